@@ -5,6 +5,52 @@
 #include "FStdbConnectionId.h"
 #include "FStdbIdentity.h"
 
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+#include <emmintrin.h>
+#endif
+
+// True if no byte has the high bit set, checks 16 bytes per step where SIMD is available
+static bool IsAscii(const uint8* Bytes, int32 Num)
+{
+    int32 i = 0;
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+    for (; i + 16 <= Num; i += 16)
+    {
+        if (vmaxvq_u8(vld1q_u8(Bytes + i)) & 0x80)
+        {
+            return false;
+        }
+    }
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+    for (; i + 16 <= Num; i += 16)
+    {
+        if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Bytes + i))) != 0)
+        {
+            return false;
+        }
+    }
+#endif
+    for (; i + 8 <= Num; i += 8)
+    {
+        uint64 Word;
+        FMemory::Memcpy(&Word, Bytes + i, sizeof(Word));
+        if (Word & 0x8080808080808080ull)
+        {
+            return false;
+        }
+    }
+    for (; i < Num; ++i)
+    {
+        if (Bytes[i] & 0x80)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 FBinaryReader::FBinaryReader(uint8* InData, int64 InSize, bool bInOwnsData)
     : Data(InData)
     , Size(InSize)
@@ -13,6 +59,14 @@ FBinaryReader::FBinaryReader(uint8* InData, int64 InSize, bool bInOwnsData)
 {
 }
 
+FBinaryReader::FBinaryReader(const uint8* InData, int64 InSize)
+    : Data(const_cast<uint8*>(InData))
+    , Size(InSize)
+    , Position(0)
+    , bOwnsData(false)
+{
+}
+
 FBinaryReader::FBinaryReader(const TArray<uint8>& InData)
     : Data(const_cast<uint8*>(InData.GetData()))
     , Size(InData.Num())
@@ -21,6 +75,14 @@ FBinaryReader::FBinaryReader(const TArray<uint8>& InData)
 {
 }
 
+FBinaryReader::FBinaryReader(TArrayView<const uint8> InData)
+    : Data(const_cast<uint8*>(InData.GetData()))
+    , Size(InData.Num())
+    , Position(0)
+    , bOwnsData(false)
+{
+}
+
 FBinaryReader::~FBinaryReader()
 {
     if (bOwnsData && Data)
@@ -43,6 +105,26 @@ void FBinaryReader::ReadBytes(void* OutData, int64 Count)
     Position += Count;
 }
 
+TArrayView<const uint8> FBinaryReader::ReadBytesView(int64 Count)
+{
+    EnsureRemaining(Count);
+    TArrayView<const uint8> View(Data + Position, Count);
+    Position += Count;
+    return View;
+}
+
+TArrayView<const uint8> FBinaryReader::ReadByteArrayView()
+{
+    int32 Length = ReadInt32();
+
+    if (Length < 0)
+    {
+        return TArrayView<const uint8>();
+    }
+
+    return ReadBytesView(Length);
+}
+
 bool FBinaryReader::ReadBool()
 {
     return ReadByte() != 0;
@@ -215,28 +297,41 @@ TOptional<double> FBinaryReader::ReadOptionalDouble()
 
 FString FBinaryReader::ReadString()
 {
-    // Read string length first
-    int32 Length = ReadInt32();
-    
-    if (Length < 0)
+    return DecodeUtf8(ReadStringView());
+}
+
+FUtf8StringView FBinaryReader::ReadStringView()
+{
+    // Same encoding as a byte array: u32 length, then the UTF-8 bytes
+    const TArrayView<const uint8> Bytes = ReadByteArrayView();
+    return FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Bytes.GetData()), Bytes.Num());
+}
+
+FString FBinaryReader::DecodeUtf8(FUtf8StringView Utf8)
+{
+    const int32 Length = Utf8.Len();
+    if (Length <= 0)
     {
-        // Handle null or invalid string
         return FString();
     }
-    
-    EnsureRemaining(Length);
-    
-    // Convert to FString
-    FString Result;
-    Result.Reserve(Length);
-    
-    // Assuming UTF-8 encoding
-    for (int32 i = 0; i < Length; ++i)
+
+    const uint8* Bytes = reinterpret_cast<const uint8*>(Utf8.GetData());
+    if (IsAscii(Bytes, Length))
     {
-        Result.AppendChar(static_cast<TCHAR>(Data[Position++]));
+        // One TCHAR per byte, written straight into the string's buffer
+        FString Result;
+        TArray<TCHAR>& Chars = Result.GetCharArray();
+        Chars.SetNumUninitialized(Length + 1);
+        for (int32 i = 0; i < Length; ++i)
+        {
+            Chars[i] = static_cast<TCHAR>(Bytes[i]);
+        }
+        Chars[Length] = TEXT('\0');
+        return Result;
     }
-    
-    return Result;
+
+    const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Bytes), Length);
+    return FString(Converted.Length(), Converted.Get());
 }
 
 TOptional<FString> FBinaryReader::ReadOptionalString()
@@ -365,28 +460,4 @@ FStdbIdentity FBinaryReader::ReadIdentity()
 TArray<FString> FBinaryReader::ReadStringArray()
 {
     return ReadArray<FString>([](FBinaryReader& Reader) { return Reader.ReadString(); });
-}
-
-template<typename T>
-TArray<T> FBinaryReader::ReadPrimitiveArray()
-{
-    int32 Length = ReadInt32();
-    
-    if (Length < 0)
-    {
-        return TArray<T>();
-    }
-    
-    TArray<T> Result;
-    Result.SetNum(Length);
-    
-    if (Length > 0)
-    {
-        // Read directly into the array's buffer for performance
-        EnsureRemaining(Length * sizeof(T));
-        FMemory::Memcpy(Result.GetData(), Data + Position, Length * sizeof(T));
-        Position += Length * sizeof(T);
-    }
-    
-    return Result;
 }
\ No newline at end of file
@@ -47,13 +47,10 @@ void FBinaryWriter::Reset()
     Position = 0;
 }
 
-void FBinaryWriter::EnsureCapacity(int64 AdditionalBytes)
+void FBinaryWriter::Grow(int64 NeededSize)
 {
-    int64 NeededSize = Position + AdditionalBytes;
-    if (NeededSize > Data->Num())
-    {
-        Data->SetNum(NeededSize);
-    }
+    // Every byte up to NeededSize is about to be written, no point zeroing them
+    Data->SetNumUninitialized(NeededSize);
 }
 
 void FBinaryWriter::WriteBytes(const void* InData, int64 Count)
@@ -66,6 +63,21 @@ void FBinaryWriter::WriteBytes(const void* InData, int64 Count)
     Position += Count;
 }
 
+TArrayView<uint8> FBinaryWriter::WriteUninitialized(int64 Count)
+{
+    check(Count >= 0);
+    EnsureCapacity(Count);
+    TArrayView<uint8> Span(Data->GetData() + Position, static_cast<int32>(Count));
+    Position += Count;
+    return Span;
+}
+
+void FBinaryWriter::PatchInt32(int64 At, int32 Value)
+{
+    check(At >= 0 && At + static_cast<int64>(sizeof(int32)) <= Data->Num());
+    FMemory::Memcpy(Data->GetData() + At, &Value, sizeof(int32));
+}
+
 void FBinaryWriter::WriteBool(bool Value)
 {
     WriteByte(Value ? 1 : 0);
@@ -246,6 +258,16 @@ void FBinaryWriter::WriteString(const FString& Value)
     }
 }
 
+void FBinaryWriter::WriteString(FUtf8StringView Value)
+{
+    // Already UTF-8, written as is
+    WriteInt32(Value.Len());
+    if (Value.Len() > 0)
+    {
+        WriteBytes(Value.GetData(), Value.Len());
+    }
+}
+
 void FBinaryWriter::WriteOptionalString(const TOptional<FString>& Value)
 {
     WriteBool(Value.IsSet());
@@ -339,16 +361,4 @@ void FBinaryWriter::WriteIdentity(const FStdbIdentity& Value)
 void FBinaryWriter::WriteStringArray(const TArray<FString>& Array)
 {
     WriteArray<FString>(Array, [](FBinaryWriter& Writer, const FString& Str) { Writer.WriteString(Str); });
-}
-
-template<typename T>
-void FBinaryWriter::WritePrimitiveArray(const TArray<T>& Array)
-{
-    WriteInt32(Array.Num());
-    
-    if (Array.Num() > 0)
-    {
-        // Write directly from the array's buffer for performance
-        WriteBytes(Array.GetData(), Array.Num() * sizeof(T));
-    }
 }
\ No newline at end of file
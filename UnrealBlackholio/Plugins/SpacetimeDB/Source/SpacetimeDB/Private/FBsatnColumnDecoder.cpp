@@ -0,0 +1,130 @@
+#include "ClientApi/FBsatnColumnDecoder.h"
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+#include <xmmintrin.h>
+#endif
+
+static constexpr int32 VECTOR_ROW_SIZE = 16;
+
+// The vector path handles dense columns made of whole 4 byte lanes of a 16 byte row, one or two lanes wide
+static bool HasVectorLayout(int32 RowSize, TArrayView<const FBsatnColumn> Columns)
+{
+	if (RowSize != VECTOR_ROW_SIZE)
+	{
+		return false;
+	}
+	for (const FBsatnColumn& Column : Columns)
+	{
+		if (Column.Offset % 4 != 0 || (Column.Size != 4 && Column.Size != 8) || (Column.Stride != 0 && Column.Stride != Column.Size))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Decodes rows in groups of four, returns how many rows were done
+static int32 DecodeVectorRows(const uint8* Src, int32 NumRows, TArrayView<const FBsatnColumn> Columns)
+{
+	int32 Row = 0;
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+	for (; Row + 4 <= NumRows; Row += 4)
+	{
+		// De-interleaving load: Lanes.val[k] holds the k-th 4 byte field of the four rows
+		const uint32x4x4_t Lanes = vld4q_u32(reinterpret_cast<const uint32*>(Src + Row * VECTOR_ROW_SIZE));
+		for (const FBsatnColumn& Column : Columns)
+		{
+			uint32* Dest = reinterpret_cast<uint32*>(Column.Dest + Row * Column.Size);
+			const int32 Lane = Column.Offset / 4;
+			if (Column.Size == 4)
+			{
+				vst1q_u32(Dest, Lanes.val[Lane]);
+			}
+			else
+			{
+				const uint32x4x2_t Pair = {{Lanes.val[Lane], Lanes.val[Lane + 1]}};
+				vst2q_u32(Dest, Pair);
+			}
+		}
+	}
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+	for (; Row + 4 <= NumRows; Row += 4)
+	{
+		// Only moves and shuffles go through the float registers, the bits are untouched
+		const float* RowData = reinterpret_cast<const float*>(Src + Row * VECTOR_ROW_SIZE);
+		__m128 Lanes[4] = {
+			_mm_loadu_ps(RowData),
+			_mm_loadu_ps(RowData + 4),
+			_mm_loadu_ps(RowData + 8),
+			_mm_loadu_ps(RowData + 12)
+		};
+		_MM_TRANSPOSE4_PS(Lanes[0], Lanes[1], Lanes[2], Lanes[3]);
+
+		for (const FBsatnColumn& Column : Columns)
+		{
+			float* Dest = reinterpret_cast<float*>(Column.Dest + Row * Column.Size);
+			const int32 Lane = Column.Offset / 4;
+			if (Column.Size == 4)
+			{
+				_mm_storeu_ps(Dest, Lanes[Lane]);
+			}
+			else
+			{
+				// Re-interleave two lanes into 8 byte values like FDbVector2
+				_mm_storeu_ps(Dest, _mm_unpacklo_ps(Lanes[Lane], Lanes[Lane + 1]));
+				_mm_storeu_ps(Dest + 4, _mm_unpackhi_ps(Lanes[Lane], Lanes[Lane + 1]));
+			}
+		}
+	}
+#endif
+	return Row;
+}
+
+bool FBsatnColumnDecoder::DecodeFixedRows(const FBsatnRowList& Rows, TArrayView<const FBsatnColumn> Columns)
+{
+	const int32 RowSize = Rows.GetFixedRowSize();
+	if (RowSize <= 0)
+	{
+		return false;
+	}
+	for (const FBsatnColumn& Column : Columns)
+	{
+		if (Column.Offset < 0 || Column.Size <= 0 || Column.Offset + Column.Size > RowSize || (Column.Stride != 0 && Column.Stride < Column.Size))
+		{
+			return false;
+		}
+	}
+
+	const int32 NumRows = Rows.Num();
+	const uint8* Src = Rows.RowsData.GetData();
+
+	int32 Row = 0;
+	if (HasVectorLayout(RowSize, Columns))
+	{
+		Row = DecodeVectorRows(Src, NumRows, Columns);
+	}
+
+	for (; Row < NumRows; ++Row)
+	{
+		const uint8* RowData = Src + static_cast<int64>(Row) * RowSize;
+		for (const FBsatnColumn& Column : Columns)
+		{
+			uint8* Dest = Column.Dest + static_cast<int64>(Row) * (Column.Stride != 0 ? Column.Stride : Column.Size);
+			switch (Column.Size)
+			{
+			case 4:
+				FMemory::Memcpy(Dest, RowData + Column.Offset, 4);
+				break;
+			case 8:
+				FMemory::Memcpy(Dest, RowData + Column.Offset, 8);
+				break;
+			default:
+				FMemory::Memcpy(Dest, RowData + Column.Offset, Column.Size);
+				break;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,62 @@
+#include "FStdbBufferPool.h"
+
+FStdbBufferPool::FStdbBufferPool(int32 InMaxPooledBuffers, int64 InMaxPooledCapacity)
+	: MaxPooledBuffers(InMaxPooledBuffers)
+	  , MaxPooledCapacity(InMaxPooledCapacity)
+{
+}
+
+FStdbBufferPool::~FStdbBufferPool()
+{
+	for (TArray<uint8>* Buffer : FreeBuffers)
+	{
+		delete Buffer;
+	}
+	FreeBuffers.Empty();
+}
+
+FStdbSharedBuffer FStdbBufferPool::Acquire(int64 MinCapacity)
+{
+	TArray<uint8>* Buffer = nullptr;
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (FreeBuffers.Num() > 0)
+		{
+			Buffer = FreeBuffers.Pop(/* bAllowShrinking = */ false);
+		}
+	}
+
+	if (!Buffer)
+	{
+		Buffer = new TArray<uint8>();
+	}
+	Buffer->Reset(static_cast<int32>(MinCapacity));
+
+	// A buffer released after its pool is gone is simply freed
+	TWeakPtr<FStdbBufferPool, ESPMode::ThreadSafe> WeakPool = AsShared();
+	return MakeShareable(Buffer, [WeakPool](TArray<uint8>* Released)
+	{
+		if (TSharedPtr<FStdbBufferPool, ESPMode::ThreadSafe> Pool = WeakPool.Pin())
+		{
+			Pool->Release(Released);
+		}
+		else
+		{
+			delete Released;
+		}
+	});
+}
+
+void FStdbBufferPool::Release(TArray<uint8>* Buffer)
+{
+	if (Buffer->GetAllocatedSize() <= MaxPooledCapacity)
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (FreeBuffers.Num() < MaxPooledBuffers)
+		{
+			FreeBuffers.Add(Buffer);
+			return;
+		}
+	}
+	delete Buffer;
+}
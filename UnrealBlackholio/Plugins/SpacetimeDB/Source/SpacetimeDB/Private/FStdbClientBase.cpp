@@ -10,10 +10,53 @@
 #include "StdbTypes.h"
 #include "ClientApi/FClientMessage.h"
 #include "ClientApi/FServerMessage.h"
+#include "Misc/QueuedThreadPool.h"
+#include "FStdbDecompressor.h"
+#include "FStdbMessageArena.h"
 
 
 static const int32 MAX_MESSAGE_SIZE = 0x4000000; // 64MB
 static const double CONNECT_TIMEOUT_S = 10.0;
+static const uint32 DECODE_WORKER_STACK_SIZE = 256 * 1024;
+// How long the websocket thread waits for room in a full received queue before checking for shutdown
+static const double RECEIVE_STALL_WAIT_MS = 10.0;
+// Minimum time between two warnings about the received queue being full
+static const double RECEIVE_STALL_WARNING_INTERVAL_S = 5.0;
+
+/**
+ * FStdbDecodeWork: Decompresses and deserializes one raw message on the connection's decode pool.
+ * The connection allocates one per decode it allows in flight and reuses them, queueing work never allocates.
+ */
+class FStdbDecodeWork : public IQueuedWork
+{
+public:
+	explicit FStdbDecodeWork(FStdbClientBase* InClient)
+		: Client(InClient)
+	{
+	}
+
+	virtual void DoThreadedWork() override
+	{
+		Client->DecodeMessage(Sequence, Raw);
+		Raw = FStdbClientBase::FUnprocessedMessage();
+		Client->ReturnDecodeWork(this);
+	}
+
+	// Only abandoned when the pool is destroyed with the connection, nothing is waiting on the result then
+	virtual void Abandon() override
+	{
+		Raw = FStdbClientBase::FUnprocessedMessage();
+		Client->ReturnDecodeWork(this);
+	}
+
+	virtual const TCHAR* GetDebugName() const override { return TEXT("FStdbDecodeWork"); }
+
+	uint64 Sequence = 0;
+	FStdbClientBase::FUnprocessedMessage Raw;
+
+private:
+	FStdbClientBase* Client;
+};
 
 FStdbClientBase::FStdbClientBase(const FStdbConnectOptions& InOptions,
                          const FString& InAuth,
@@ -28,10 +71,30 @@ FStdbClientBase::FStdbClientBase(const FStdbConnectOptions& InOptions,
 	  , Compression(InCompression)
 	  , bLightMode(bInLight)
 	  , bStop(false)
+	  , RawMessageQueue(InOptions.MessageQueueCapacity)
+	  , ProcessedMessageQueue(InOptions.MessageQueueCapacity)
+	  , Subscriptions([this](const FClientMessage& Message) { return EnqueueClientMessage(Message); })
 {
 	UE_LOG(LogStdb, Log, TEXT("FStdbClient constructing"));
 	ConnectionIdHex = GenerateRandomConnectionId();
-	WakeEvent = FPlatformProcess::GetSynchEventFromPool(true);
+	BufferPool = MakeShared<FStdbBufferPool, ESPMode::ThreadSafe>();
+	// Auto reset, a wake up that arrives while the client thread is busy is kept for its next wait
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	RawQueueSpaceEvent = FPlatformProcess::GetSynchEventFromPool(false);
+
+	// Every decode in flight holds one of these and one release slot until the game thread queue takes it,
+	// so at most a ring's worth of messages sit between the received and the decoded queue
+	MaxDecodesInFlight = RawMessageQueue.GetCapacity();
+	DecodeWork.Reserve(MaxDecodesInFlight);
+	FreeDecodeWork.Reserve(MaxDecodesInFlight);
+	for (int32 i = 0; i < MaxDecodesInFlight; ++i)
+	{
+		FreeDecodeWork.Add(DecodeWork.Emplace_GetRef(MakeUnique<FStdbDecodeWork>(this)).Get());
+	}
+	PendingRelease.SetNum(MaxDecodesInFlight);
+	SetFrameBudgetMs(ConnectOptions.FrameBudgetMs);
+	Sender = MakeUnique<FStdbSender>([this](const TArray<uint8>& Frame) { return SendFrame(Frame); },
+	                                 ConnectOptions.MessageQueueCapacity);
 }
 
 FStdbClientBase::~FStdbClientBase()
@@ -47,11 +110,24 @@ FStdbClientBase::~FStdbClientBase()
 		Thread = nullptr;
 	}
 
+	// Waits for in-flight decodes, nothing is queued to the pool once the client thread has stopped
+	if (DecodePool)
+	{
+		DecodePool->Destroy();
+		delete DecodePool;
+		DecodePool = nullptr;
+	}
+
 	if (WakeEvent)
 	{
 		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
 		WakeEvent = nullptr;
 	}
+	if (RawQueueSpaceEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(RawQueueSpaceEvent);
+		RawQueueSpaceEvent = nullptr;
+	}
 }
 
 bool FStdbClientBase::Init() { return true; }
@@ -63,24 +139,42 @@ uint32 FStdbClientBase::Run()
 		if (!bIsConnected && bStartConnection)
 		{
 			bIsConnected = ConnectWebSocket();
+			if (bIsConnected)
+			{
+				// Flush whatever was queued while connecting
+				Sender->Wake();
+			}
 		}
 
-		FUnprocessedMessage Raw;
-		while (RawMessageQueue.Dequeue(Raw))
+		if (bCloseRequested && WS.IsValid())
 		{
-			//Deserialize / decompress
-			TSharedPtr<FServerMessage> Processed = MakeShared<FServerMessage>();
-			DecompressAndDeserialize(Raw.Bytes, Raw.Timestamp, *Processed);
-
-			//Enqueue for game thread
-			ProcessedMessageQueue.Enqueue(Processed);
+			bCloseRequested = false;
+			FString Reason;
+			{
+				FScopeLock Lock(&CloseReasonLock);
+				Reason = CloseReason;
+			}
+			// 1011: Internal error
+			WS->Close(1011, Reason);
 		}
 
-		// TODO: Move to a separate thread
-		FClientMessage ClientMessage;
-		while (ClientMessageQueue.Dequeue(ClientMessage))
+		// Deserialize / decompress on the decode pool, results are released in arrival order.
+		// Once the decodes in flight reach the cap messages stay in the received queue, which
+		// fills up and holds back the websocket thread
+		while (!RawMessageQueue.IsEmpty() && NumDecodesInFlight.load(std::memory_order_acquire) < MaxDecodesInFlight)
 		{
-			SendClientMessage(ClientMessage);
+			FStdbDecodeWork* Work = AcquireDecodeWork();
+			if (!Work)
+			{
+				break;
+			}
+			// This is the only consumer, the queue can't have emptied since the check
+			verify(RawMessageQueue.Dequeue(Work->Raw));
+			RawQueueSpaceEvent->Trigger();
+
+			Work->Sequence = NextDecodeSequence++;
+			NumDecodesInFlight.fetch_add(1, std::memory_order_acq_rel);
+			DecodePool->AddQueuedWork(Work);
 		}
 
 		WakeEvent->Wait(FTimespan::FromMilliseconds(50));
@@ -92,6 +186,7 @@ void FStdbClientBase::Stop()
 {
 	bStop = true;
 	if (WakeEvent) WakeEvent->Trigger();
+	if (RawQueueSpaceEvent) RawQueueSpaceEvent->Trigger();
 }
 
 void FStdbClientBase::Exit()
@@ -102,8 +197,21 @@ void FStdbClientBase::Exit()
 void FStdbClientBase::Connect()
 {
 	bStop = false;
+	ClientCache.LockRegistration();
+
+	if (!DecodePool)
+	{
+		const int32 NumWorkers = ConnectOptions.DecodeWorkers > 0
+			                         ? ConnectOptions.DecodeWorkers
+			                         : FPlatformMisc::NumberOfCores() - 1;
+		FString PoolName = FString::Printf(TEXT("FStdbDecode_%s"), *NameOrAddress);
+		DecodePool = FQueuedThreadPool::Allocate();
+		verify(DecodePool->Create(FMath::Max(NumWorkers, 1), DECODE_WORKER_STACK_SIZE, TPri_Normal, *PoolName));
+	}
+
 	FString ThreadName = FString::Printf(TEXT("FStdbClient_%s"), *NameOrAddress);
 	Thread = FRunnableThread::Create(this, *ThreadName);
+	Sender->Start(FString::Printf(TEXT("FStdbSend_%s"), *NameOrAddress));
 
 	bStartConnection = true;
 }
@@ -112,21 +220,190 @@ void FStdbClientBase::Shutdown()
 {
 	bStop = true;
 	if (WakeEvent) WakeEvent->Trigger();
+	if (RawQueueSpaceEvent) RawQueueSpaceEvent->Trigger();
 
 	OnConnect.Unbind();
 	OnConnectError.Unbind();
 	OnDisconnect.Unbind();
 
+	// Stop sending before the socket goes away
+	Sender->Shutdown();
 	TeardownWebSocket();
+	ResetConnectionState();
+}
+
+void FStdbClientBase::ResetConnectionState()
+{
+	// Rows are reference counted per query set, the sets and their counts go together
+	Subscriptions.Reset();
+	ClientCache.Clear();
+	PendingReducerCalls.Reset();
+	bCacheOutOfSync = false;
+}
+
+void FStdbClientBase::DecodeMessage(uint64 Sequence, const FUnprocessedMessage& Raw)
+{
+	FProcessedMessage Processed;
+	if (Raw.bConnectionClosed)
+	{
+		Processed.bConnectionClosed = true;
+		Processed.CloseReason = Raw.CloseReason;
+		ReleaseInOrder(Sequence, MoveTemp(Processed));
+		return;
+	}
+
+	Processed.Message = MakeShared<FServerMessage>();
+	const bool bDecoded = DecompressAndDeserialize(Raw.Bytes, Raw.Timestamp, *Processed.Message);
+
+	// A message without payload still has to release its sequence slot, one that failed to decode
+	// goes through to the game thread so nothing is applied on top of the gap it leaves
+	if (!bDecoded || !Processed.Message->Payload.IsValid())
+	{
+		Processed.Message.Reset();
+		Processed.bDecodeFailed = !bDecoded;
+	}
+	else
+	{
+		// Rows are decoded into their structs here, the game thread only applies the diff
+		BuildCacheDiff(*Processed.Message, Processed.CacheDiff);
+	}
+	ReleaseInOrder(Sequence, MoveTemp(Processed));
+}
+
+void FStdbClientBase::BuildCacheDiff(const FServerMessage& Msg, FStdbCacheDiff& OutDiff) const
+{
+	switch (Msg.Type)
+	{
+	case EServerMessageType::InitialSubscription:
+		ClientCache.DecodeDatabaseUpdate(Msg.Data.Get<FInitialSubscriptionData>().DatabaseUpdate, OutDiff);
+		break;
+	case EServerMessageType::TransactionUpdate:
+		{
+			const FUpdateStatus& Status = Msg.Data.Get<FTransactionUpdateData>().Status;
+			if (Status.Type == FUpdateStatus::EStatusType::Committed)
+			{
+				ClientCache.DecodeDatabaseUpdate(Status.Data.Get<FDatabaseUpdate>(), OutDiff);
+			}
+			break;
+		}
+	case EServerMessageType::TransactionUpdateLight:
+		ClientCache.DecodeDatabaseUpdate(Msg.Data.Get<FTransactionUpdateLightData>().Update, OutDiff);
+		break;
+	case EServerMessageType::SubscribeApplied:
+		ClientCache.DecodeTableUpdate(Msg.Data.Get<FSubscribeAppliedData>().Rows.TableRows, OutDiff);
+		break;
+	case EServerMessageType::UnsubscribeApplied:
+		ClientCache.DecodeTableUpdate(Msg.Data.Get<FUnsubscribeAppliedData>().Rows.TableRows, OutDiff);
+		break;
+	case EServerMessageType::SubscribeMultiApplied:
+		ClientCache.DecodeDatabaseUpdate(Msg.Data.Get<FSubscribeMultiAppliedData>().Update, OutDiff);
+		break;
+	case EServerMessageType::UnsubscribeMultiApplied:
+		ClientCache.DecodeDatabaseUpdate(Msg.Data.Get<FUnsubscribeMultiAppliedData>().Update, OutDiff);
+		break;
+	default:
+		break;
+	}
+}
+
+FStdbDecodeWork* FStdbClientBase::AcquireDecodeWork()
+{
+	FScopeLock Lock(&DecodeWorkLock);
+	return FreeDecodeWork.Num() > 0 ? FreeDecodeWork.Pop(/* bAllowShrinking = */ false) : nullptr;
+}
+
+void FStdbClientBase::ReturnDecodeWork(FStdbDecodeWork* Work)
+{
+	{
+		FScopeLock Lock(&DecodeWorkLock);
+		FreeDecodeWork.Add(Work);
+	}
+	if (WakeEvent) WakeEvent->Trigger();
+}
+
+void FStdbClientBase::ReleaseInOrder(uint64 Sequence, FProcessedMessage&& Processed)
+{
+	FScopeLock Lock(&SequencerLock);
+	// Sequences in flight never span more than MaxDecodesInFlight, so each has a slot of its own
+	FPendingRelease& Slot = PendingRelease[Sequence % PendingRelease.Num()];
+	check(!Slot.bDecoded);
+	Slot.Processed = MoveTemp(Processed);
+	Slot.bDecoded = true;
+	++NumPendingRelease;
+	ReleasePendingLocked();
+}
+
+void FStdbClientBase::ReleasePendingLocked()
+{
+	bool bReleased = false;
+	for (;;)
+	{
+		FPendingRelease& Next = PendingRelease[NextReleaseSequence % PendingRelease.Num()];
+		if (!Next.bDecoded)
+		{
+			break;
+		}
+
+		//Enqueue for game thread, when its queue is full the rest waits here until FrameTick made room
+		if (!Next.Processed.IsEmpty() && !ProcessedMessageQueue.TryEnqueue(MoveTemp(Next.Processed)))
+		{
+			break;
+		}
+		Next = FPendingRelease();
+		--NumPendingRelease;
+		++NextReleaseSequence;
+		NumDecodesInFlight.fetch_sub(1, std::memory_order_acq_rel);
+		bReleased = true;
+	}
+
+	// The client thread may be holding back received messages until a decode slot frees up
+	if (bReleased && WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
 }
 
 void FStdbClientBase::FrameTick()
 {
-	TSharedPtr<FServerMessage> Msg;
-	while (ProcessedMessageQueue.Dequeue(Msg))
+	const double StartTime = FPlatformTime::Seconds();
+
+	// A message is one transaction and is always applied whole, the budget is only checked between messages.
+	// The first message is applied regardless so a tight budget still makes progress
+	int32 NumApplied = 0;
+	bool bOverBudget = false;
+	FProcessedMessage Processed;
+	while (ProcessedMessageQueue.Dequeue(Processed))
 	{
-		HandleProcessedMessage(Msg);
+		HandleProcessedMessage(Processed);
+		Processed = FProcessedMessage();
+		++NumApplied;
+
+		if (FrameBudgetSeconds > 0.0 && FPlatformTime::Seconds() - StartTime >= FrameBudgetSeconds)
+		{
+			bOverBudget = !ProcessedMessageQueue.IsEmpty();
+			break;
+		}
 	}
+
+	// Messages held back by a full queue. Left over ones count as deferred too, the budget
+	// is what keeps them waiting in the sequencer while the queue is full
+	int32 NumDeferred = 0;
+	{
+		FScopeLock Lock(&SequencerLock);
+		ReleasePendingLocked();
+		if (bOverBudget)
+		{
+			NumDeferred = ProcessedMessageQueue.Num() + NumPendingRelease;
+		}
+	}
+
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+	FScopeLock Lock(&StatsLock);
+	Stats.LastFrameMessagesApplied = NumApplied;
+	Stats.LastFrameMessagesDeferred = NumDeferred;
+	Stats.LastFrameDispatchSeconds = Elapsed;
+	Stats.MaxFrameDispatchSeconds = FMath::Max(Stats.MaxFrameDispatchSeconds, Elapsed);
+	Stats.FramesOverBudget += bOverBudget ? 1 : 0;
 }
 
 void FStdbClientBase::LegacySubscribe()
@@ -137,16 +414,125 @@ void FStdbClientBase::LegacySubscribe()
 		return;
 	}
 
-	// TODO: Add subscription handles
-	FSubscribeData SubscribeData = FSubscribeData({TEXT("SELECT * FROM *")}, 1);
+	// Everything under one request, use Subscribe for query sets that can be unsubscribed
+	FSubscribeData SubscribeData = FSubscribeData({TEXT("SELECT * FROM *")}, Subscriptions.AllocateRequestId());
 	FClientMessage Message = FClientMessage::Subscribe(SubscribeData);
-	ClientMessageQueue.Enqueue(Message);
-	WakeEvent->Trigger();
+	EnqueueClientMessage(Message);
+}
+
+uint32 FStdbClientBase::CallReducerWith(const FString& Reducer, TFunctionRef<void(FBinaryWriter&)> WriteArgs,
+                                        FOnReducerResult OnResult, ECallReducerFlags Flags)
+{
+	return SendReducerCall(Reducer, [&Reducer, WriteArgs, Flags](uint32 RequestId, FBinaryWriter& Writer)
+	{
+		FClientMessage::SerializeCallReducer(Reducer, WriteArgs, RequestId, static_cast<uint8>(Flags), Writer);
+	}, MoveTemp(OnResult), Flags);
+}
+
+uint32 FStdbClientBase::SendReducerCall(const FString& Reducer, TFunctionRef<void(uint32, FBinaryWriter&)> Encode,
+                                        FOnReducerResult OnResult, ECallReducerFlags Flags)
+{
+	const uint32 RequestId = NextRequestId++;
+
+	// Encoded once into a pooled buffer that goes back to the pool after it has been sent
+	FStdbSharedBuffer Frame = BufferPool->Acquire(256);
+	FBinaryWriter Writer(*Frame);
+	Encode(RequestId, Writer);
+
+	FName CoalesceKey = NAME_None;
+	if (OnResult.IsBound())
+	{
+		if (Flags != ECallReducerFlags::NoSuccessNotify)
+		{
+			PendingReducerCalls.Add(RequestId, MoveTemp(OnResult));
+		}
+	}
+	else if (CoalescedReducers.Num() > 0)
+	{
+		const FName ReducerName(*Reducer, FNAME_Find);
+		if (CoalescedReducers.Contains(ReducerName))
+		{
+			CoalesceKey = ReducerName;
+		}
+	}
+
+	if (!Sender->TryEnqueue(Frame, CoalesceKey))
+	{
+		UE_LOG(LogStdb, Warning, TEXT("Outbound queue is full, dropping call to %s"), *Reducer);
+		PendingReducerCalls.Remove(RequestId);
+		return 0;
+	}
+	return RequestId;
+}
+
+void FStdbClientBase::SetReducerCoalescing(const FString& Reducer, bool bCoalesce)
+{
+	if (bCoalesce)
+	{
+		CoalescedReducers.Add(FName(*Reducer));
+	}
+	else
+	{
+		CoalescedReducers.Remove(FName(*Reducer));
+	}
+}
+
+void FStdbClientBase::RequestClose(const FString& Reason)
+{
+	{
+		FScopeLock Lock(&CloseReasonLock);
+		CloseReason = Reason;
+	}
+	bCloseRequested = true;
+	if (WakeEvent) WakeEvent->Trigger();
 }
 
-void FStdbClientBase::HandleProcessedMessage(const TSharedPtr<FServerMessage>& Msg)
+bool FStdbClientBase::EnqueueClientMessage(const FClientMessage& ClientMessage)
+{
+	FStdbSharedBuffer Frame = BufferPool->Acquire(256);
+	FBinaryWriter Writer(*Frame);
+	FClientMessage::Serialize(ClientMessage, Writer);
+
+	if (!Sender->TryEnqueue(Frame))
+	{
+		UE_LOG(LogStdb, Warning, TEXT("Outbound queue is full, dropping client message"));
+		return false;
+	}
+	return true;
+}
+
+void FStdbClientBase::HandleProcessedMessage(FProcessedMessage& Processed)
 {
 	UE_LOG(LogStdb, Log, TEXT("FStdbClient - Handle Processed Message"));
+
+	// Every message of the connection was handled by now, its rows and query sets go with it
+	if (Processed.bConnectionClosed)
+	{
+		ResetConnectionState();
+		OnDisconnect.ExecuteIfBound(Processed.CloseReason);
+		return;
+	}
+
+	// A lost transaction can't be made up for, the connection is closed rather than applying later ones on top of it
+	if (Processed.bDecodeFailed && !bCacheOutOfSync)
+	{
+		UE_LOG(LogStdb, Error, TEXT("A server message failed to decode, the client cache no longer matches the server. Disconnecting"));
+		bCacheOutOfSync = true;
+		RequestClose(TEXT("Client failed to decode a message"));
+	}
+	if (bCacheOutOfSync)
+	{
+		return;
+	}
+
+	const TSharedPtr<FServerMessage>& Msg = Processed.Message;
+
+	// Rows were decoded on the decode worker, the cache is updated before the message's own handling
+	if (!Processed.CacheDiff.IsEmpty())
+	{
+		ClientCache.ApplyDiff(Processed.CacheDiff);
+	}
+
 	switch (Msg->Type)
 	{
 	case EServerMessageType::IdentityToken:
@@ -154,20 +540,44 @@ void FStdbClientBase::HandleProcessedMessage(const TSharedPtr<FServerMessage>& M
 			FIdentityTokenData identityToken = Msg->Data.Get<FIdentityTokenData>();
 			UE_LOG(LogStdb, Log, TEXT("FStdbClient - Handle IdentityToken with auth: %s"), *identityToken.Token);
 			this->Identity = identityToken.Identity;
+			this->ConnectionId = identityToken.ConnectionId;
 			OnConnect.ExecuteIfBound(identityToken.Identity, identityToken.Token);
 			break;
 		}
 	case EServerMessageType::InitialSubscription:
 		{
-			FInitialSubscriptionData initialSubscription = Msg->Data.Get<FInitialSubscriptionData>();
+			const FInitialSubscriptionData& initialSubscription = Msg->Data.Get<FInitialSubscriptionData>();
 			UE_LOG(LogStdb, Log, TEXT("Processing Initial Subscription"))
-			for (FTableUpdate TableUpdate : initialSubscription.DatabaseUpdate.Tables)
+			for (const FTableUpdate& TableUpdate : initialSubscription.DatabaseUpdate.Tables)
+			{
+				UE_LOG(LogStdb, Log, TEXT("   Table Update: %s: %llu"), *TableUpdate.GetTableName(), TableUpdate.NumRows);
+			}
+			break;
+		}
+	case EServerMessageType::TransactionUpdate:
+		{
+			const FTransactionUpdateData& TransactionUpdate = Msg->Data.Get<FTransactionUpdateData>();
+
+			// Request ids are per connection, only our own calls can answer a pending one
+			if (TransactionUpdate.CallerConnectionId == ConnectionId)
 			{
-				UE_LOG(LogStdb, Log, TEXT("   Table Update: %s: %llu"), *TableUpdate.TableName, TableUpdate.NumRows);
+				FOnReducerResult OnResult;
+				if (PendingReducerCalls.RemoveAndCopyValue(TransactionUpdate.ReducerCall.RequestId, OnResult))
+				{
+					OnResult.ExecuteIfBound(TransactionUpdate);
+				}
 			}
 			break;
 		}
-		
+	case EServerMessageType::SubscribeMultiApplied:
+		Subscriptions.HandleSubscribeMultiApplied(Msg->Data.Get<FSubscribeMultiAppliedData>());
+		break;
+	case EServerMessageType::UnsubscribeMultiApplied:
+		Subscriptions.HandleUnsubscribeMultiApplied(Msg->Data.Get<FUnsubscribeMultiAppliedData>());
+		break;
+	case EServerMessageType::SubscriptionError:
+		Subscriptions.HandleSubscriptionError(Msg->Data.Get<FSubscriptionErrorData>());
+		break;
 	default:
 		break;
 	}
@@ -177,12 +587,21 @@ void FStdbClientBase::HandleProcessedMessage(const TSharedPtr<FServerMessage>& M
 bool FStdbClientBase::ConnectWebSocket()
 {
 	bStartConnection = false;
+
+	EStdbCompression RequestedCompression = Compression;
+	if (!FStdbDecompressor::IsSupported(RequestedCompression))
+	{
+		UE_LOG(LogStdb, Warning, TEXT("%s compression is not available in this build, requesting uncompressed messages"),
+		       *CompressionToString(RequestedCompression));
+		RequestedCompression = EStdbCompression::None;
+	}
+
 	FString URL = FString::Printf(
 		TEXT("%s/v1/database/%s/subscribe?connection_id=%s&compression=%s"),
 		*Host,
 		*NameOrAddress,
 		*ConnectionIdHex,
-		*CompressionToString(Compression)
+		*CompressionToString(RequestedCompression)
 	);
 	if (bLightMode)
 	{
@@ -255,6 +674,7 @@ void FStdbClientBase::TeardownWebSocket()
 		WS->OnConnected().RemoveAll(this);
 		WS->OnConnectionError().RemoveAll(this);
 		bCallbacksInitialized = false;
+		PartialMessage = FUnprocessedMessage();
 		WS->Close();
 		WS.Reset();
 	}
@@ -279,19 +699,58 @@ void FStdbClientBase::HandleRawMessage(const void* Data, SIZE_T Size, SIZE_T Byt
 	if (bStop)
 		return;
 
-	// Enforce 64MB cap
-	if (Size > MAX_MESSAGE_SIZE)
+	// Frames of one message arrive back to back, BytesRemaining is how much of it is still to come
+	const SIZE_T Received = PartialMessage.Bytes.IsValid() ? PartialMessage.Bytes->Num() : 0;
+
+	// Enforce 64MB cap on the whole message
+	if (Received + Size + BytesRemaining > MAX_MESSAGE_SIZE)
 	{
+		PartialMessage = FUnprocessedMessage();
 		// close with “too big”
 		WS->Close(1013, TEXT("Message too big")); // 1013: Too big
 		return;
 	}
 
-	// Add to Unprocessed Queue
-	FUnprocessedMessage unprocessedMessage;
-	unprocessedMessage.Timestamp = FDateTime::UtcNow();
-	unprocessedMessage.Bytes.Append(reinterpret_cast<const uint8*>(Data), Size);
-	RawMessageQueue.Enqueue(unprocessedMessage);
+	// Reserve the full message on its first fragment so later fragments append without reallocating
+	if (!PartialMessage.Bytes.IsValid())
+	{
+		PartialMessage.Timestamp = FDateTime::UtcNow();
+		PartialMessage.Bytes = BufferPool->Acquire(Size + BytesRemaining);
+	}
+
+	// Append into the reassembly buffer, this is the only copy of the frame the client makes
+	PartialMessage.Bytes->Append(reinterpret_cast<const uint8*>(Data), Size);
+	if (BytesRemaining > 0)
+		return;
+
+	EnqueueRawMessage(PartialMessage);
+	PartialMessage = FUnprocessedMessage();
+}
+
+void FStdbClientBase::EnqueueRawMessage(FUnprocessedMessage& Message)
+{
+	// Add to Unprocessed Queue once the message is complete. When it is full the websocket
+	// thread waits for the client thread, which pushes back on the socket instead of buffering
+	if (!RawMessageQueue.TryEnqueue(MoveTemp(Message)))
+	{
+		const double StallStart = FPlatformTime::Seconds();
+		if (StallStart - LastReceiveStallWarning >= RECEIVE_STALL_WARNING_INTERVAL_S)
+		{
+			UE_LOG(LogStdb, Warning, TEXT("Received message queue is full, waiting for the client thread"));
+			LastReceiveStallWarning = StallStart;
+		}
+
+		do
+		{
+			if (WakeEvent) WakeEvent->Trigger();
+			RawQueueSpaceEvent->Wait(FTimespan::FromMilliseconds(RECEIVE_STALL_WAIT_MS));
+		}
+		while (!bStop && !RawMessageQueue.TryEnqueue(MoveTemp(Message)));
+
+		FScopeLock Lock(&StatsLock);
+		++Stats.ReceiveStalls;
+		Stats.ReceiveStallSeconds += FPlatformTime::Seconds() - StallStart;
+	}
 	if (WakeEvent) WakeEvent->Trigger();
 }
 
@@ -304,80 +763,96 @@ void FStdbClientBase::HandleClosed(int32 StatusCode, const FString& Reason, bool
 	FString Msg = bWasClean
 		              ? FString()
 		              : FString::Printf(TEXT("WebSocket closed: %s"), *Reason);
-	// Do we need to do anything here?
 
-	//OnDisconnect.ExecuteIfBound(Msg);
+	// Queued behind the messages received before the close, the game thread resets the
+	// cache and subscriptions and calls OnDisconnect once it got through them
+	PartialMessage = FUnprocessedMessage();
+	FUnprocessedMessage Closed;
+	Closed.bConnectionClosed = true;
+	Closed.CloseReason = MoveTemp(Msg);
+	EnqueueRawMessage(Closed);
+}
+
+bool FStdbClientBase::SendFrame(const TArray<uint8>& Frame) const
+{
+	// Messages queued before the socket is up wait for it
+	if (!bIsConnected || !WS.IsValid())
+		return false;
+
+	// Client messages go out uncompressed, SpacetimeDB has no compressed client frames
+	// LwsWebSocket is threaded and has an internal queue that is sent FIFO, it copies the frame
+	WS->Send(Frame.GetData(), Frame.Num(), true);
+	return true;
 }
 
-void FStdbClientBase::SendClientMessage(const FClientMessage& ClientMessage) const
+FStdbConnectionStats FStdbClientBase::GetStats() const
 {
-	// TODO: Add compression
-	FBinaryWriter writer;
-	FClientMessage::Serialize(ClientMessage, writer);
-	const TArray<uint8>& Data = writer.GetData();
-	// LwsWebSocket is threaded and has an internal queue that is sent FIFO
-	WS->Send(Data.GetData(), Data.Num(), true);
+	FStdbConnectionStats Snapshot;
+	{
+		FScopeLock Lock(&StatsLock);
+		Snapshot = Stats;
+	}
+	Snapshot.RawMessageQueue = RawMessageQueue.GetStats();
+	Snapshot.ProcessedMessageQueue = ProcessedMessageQueue.GetStats();
+	Snapshot.OutboundMessageQueue = Sender->GetQueueStats();
+	return Snapshot;
 }
 
-void FStdbClientBase::DecompressAndDeserialize(const TArray<uint8>& InBytes, const FDateTime& InTimestamp,
-                                           FServerMessage& OutMessage)
+bool FStdbClientBase::DecompressAndDeserialize(const FStdbSharedBuffer& InBytes, const FDateTime& InTimestamp,
+                                           FServerMessage& OutMessage) const
 {
 	UE_LOG(LogStdb, Log, TEXT("DecompressAndDeserialize"));
-	if (InBytes.Num() < 1)
+	if (!InBytes.IsValid() || InBytes->Num() < 1)
 	{
 		UE_LOG(LogStdb, Error, TEXT("Empty message received"));
-		return;
+		return true;
 	}
-	uint8 CompressionByte = InBytes[0];
-	EStdbCompression Algo = static_cast<EStdbCompression>(CompressionByte);
-	TArray<uint8> CompressedData;
-	CompressedData.Append(InBytes.GetData() + 1, InBytes.Num() - 1);
-	
-	TArray<uint8> WorkingBuffer;
-	switch (Compression)
+	// Every message carries its own compression tag, the server may skip compression for small messages
+	const EStdbCompression Algo = static_cast<EStdbCompression>((*InBytes)[0]);
+	const TArrayView<const uint8> Body(InBytes->GetData() + 1, InBytes->Num() - 1);
+
+	// The decoded message keeps its payload alive, its row lists are views into it.
+	// Uncompressed messages are decoded straight out of the receive buffer, skipping the tag byte.
+	FStdbSharedBuffer Payload;
+	TArrayView<const uint8> Decoded;
+	if (Algo == EStdbCompression::None)
 	{
-	case EStdbCompression::None:
-		// No compression: just copy
-		WorkingBuffer = CompressedData;
-		break;
-
-	// TODO: Repair this.. it seems that Zlib isn't working with Gzip or the data from SpacetimeDb isn't Gzip'd
-	case EStdbCompression::Gzip:
+		Payload = InBytes;
+		Decoded = Body;
+	}
+	else
+	{
+		Payload = BufferPool->Acquire(0);
+		if (!FStdbDecompressor::Decompress(Algo, Body, *Payload))
 		{
-			// Pre‑allocate an approximate size (you may adjust this)
-			int32 UncompressedSize = CompressedData.Num() * 4;
-			WorkingBuffer.SetNum(UncompressedSize);
-
-			if (!FCompression::UncompressMemory(
-				NAME_Zlib,
-				WorkingBuffer.GetData(),
-				UncompressedSize,
-				CompressedData.GetData(),
-				CompressedData.Num()
-			))
-			{
-				UE_LOG(LogStdb, Error, TEXT("Gzip decompression failed"));
-				WorkingBuffer.Reset();
-			}
-			else
-			{
-				// Shrink to actual size
-				WorkingBuffer.SetNum(UncompressedSize, /* bAllowShrinking = */ true);
-			}
+			UE_LOG(LogStdb, Error, TEXT("Failed to decompress message with compression tag %d"), static_cast<int32>(Algo));
+			return false;
 		}
-		break;
-
-	default:
-		// Unknown compression type
-		UE_LOG(LogStdb, Warning, TEXT("Unsupported compression mode; passing through raw bytes"));
-		WorkingBuffer = CompressedData;
-		break;
+		Decoded = *Payload;
 	}
 
 	// No data no message
-	if (WorkingBuffer.Num() <= 0)
-		return;
+	if (Decoded.Num() <= 0)
+		return true;
 
-	FBinaryReader reader = FBinaryReader(WorkingBuffer.GetData(), WorkingBuffer.Num());
-	OutMessage = FServerMessage::Deserialize(reader);
+	// Offsets and per-table arrays of the message come from one arena that is released with it
+	TSharedPtr<FStdbMessageArena, ESPMode::ThreadSafe> Arena = MakeShared<FStdbMessageArena, ESPMode::ThreadSafe>();
+	bool bInflated;
+	{
+		FStdbArenaScope ArenaScope(Arena.Get());
+		FBinaryReader reader = FBinaryReader(Decoded);
+		OutMessage = FServerMessage::Deserialize(reader);
+		bInflated = OutMessage.DecompressQueryUpdates();
+	}
+	// The message keeps its arena either way, its arrays are freed with it
+	OutMessage.Arena = MoveTemp(Arena);
+	OutMessage.Payload = MoveTemp(Payload);
+
+	// Applying only the tables that did inflate would leave the cache half way through the transaction
+	if (!bInflated)
+	{
+		UE_LOG(LogStdb, Error, TEXT("Failed to decode the query updates of a message of type %d"), static_cast<int32>(OutMessage.Type));
+		return false;
+	}
+	return true;
 }
@@ -34,6 +34,24 @@ FStdbClientBuilder& FStdbClientBuilder::WithLight(bool bInLight)
 	return *this;
 }
 
+FStdbClientBuilder& FStdbClientBuilder::WithDecodeWorkers(int32 InDecodeWorkers)
+{
+	DecodeWorkers = InDecodeWorkers;
+	return *this;
+}
+
+FStdbClientBuilder& FStdbClientBuilder::WithFrameBudget(float InFrameBudgetMs)
+{
+	FrameBudgetMs = InFrameBudgetMs;
+	return *this;
+}
+
+FStdbClientBuilder& FStdbClientBuilder::WithTables(TFunction<void(FStdbClientCache&)> InRegisterTables)
+{
+	RegisterTablesCb = InRegisterTables;
+	return *this;
+}
+
 FStdbClientBuilder& FStdbClientBuilder::OnConnect(TFunction<void(FStdbIdentity, FString)> InOnConnect)
 {
 	OnConnectCb = InOnConnect;
@@ -56,6 +74,8 @@ TSharedPtr<FStdbClientBase> FStdbClientBuilder::Build(UObject* WorldContextObjec
 {
 	FStdbConnectOptions Options;
 	Options.Protocol = TEXT("v1.bsatn.spacetimedb");
+	Options.DecodeWorkers = DecodeWorkers;
+	Options.FrameBudgetMs = FrameBudgetMs;
 
 	TSharedPtr<FStdbClientBase> Client = MakeShared<FStdbClientBase>(
 		Options,
@@ -66,6 +86,11 @@ TSharedPtr<FStdbClientBase> FStdbClientBuilder::Build(UObject* WorldContextObjec
 		bLight
 	);
 
+	if (RegisterTablesCb)
+	{
+		RegisterTablesCb(Client->GetClientCache());
+	}
+
 	// Wire up callbacks to FStdbClient (C++ delegates)
 	if (OnConnectCb)
 	{
@@ -0,0 +1,245 @@
+#include "ClientCache/FStdbClientCache.h"
+
+#include "LogStdb.h"
+#include "Async/ParallelFor.h"
+
+// Table ids at or above this are resolved by name every time instead of getting a slot in TablesById
+static const uint32 MAX_TABLE_ID = 1 << 16;
+// Rows below which a message's tables are decoded one after the other, fanning out costs more than it saves
+static const uint64 MIN_PARALLEL_DECODE_ROWS = 4096;
+
+FStdbClientCache::~FStdbClientCache()
+{
+	// Builds in flight use the tables
+	SnapshotPipe.WaitUntilEmpty();
+
+	FreeRetiredSnapshots();
+	delete PublishedSnapshot.exchange(nullptr);
+}
+
+IStdbTableCache* FStdbClientCache::FindTable(const FString& TableName) const
+{
+	const TUniquePtr<IStdbTableCache>* Table = Tables.Find(TableName);
+	return Table ? Table->Get() : nullptr;
+}
+
+IStdbTableCache* FStdbClientCache::ResolveTable(const FTableUpdate& Update) const
+{
+	const bool bCacheable = Update.TableId < MAX_TABLE_ID;
+	const int32 Index = static_cast<int32>(Update.TableId);
+	if (bCacheable)
+	{
+		FReadScopeLock Lock(TableIdLock);
+		if (TablesById.IsValidIndex(Index) && TablesById[Index].bResolved)
+		{
+			return TablesById[Index].Table;
+		}
+	}
+
+	const FString TableName = Update.GetTableName();
+	IStdbTableCache* Table = FindTable(TableName);
+	if (!Table)
+	{
+		UE_LOG(LogStdb, Verbose, TEXT("No cache registered for table %s"), *TableName);
+	}
+
+	if (bCacheable)
+	{
+		FWriteScopeLock Lock(TableIdLock);
+		if (!TablesById.IsValidIndex(Index))
+		{
+			TablesById.SetNum(Index + 1);
+		}
+		TablesById[Index] = {Table, true};
+	}
+	return Table;
+}
+
+void FStdbClientCache::LockRegistration()
+{
+	if (bRegistrationLocked)
+		return;
+	bRegistrationLocked = true;
+
+	// First version, copied here once. Nothing runs on the snapshot pipe before registration is locked
+	TSharedRef<FStdbCacheSnapshot, ESPMode::ThreadSafe> First = MakeShared<FStdbCacheSnapshot, ESPMode::ThreadSafe>();
+	First->Version = Version;
+	for (const TPair<FString, TUniquePtr<IStdbTableCache>>& Pair : Tables)
+	{
+		if (Pair.Value->HasSnapshots())
+		{
+			First->Tables.Add(Pair.Key, Pair.Value->SeedSnapshot(Version));
+		}
+	}
+	SwapSnapshot(First);
+}
+
+FStdbCacheSnapshotPtr FStdbClientCache::GetSnapshot() const
+{
+	NumSnapshotReaders.fetch_add(1);
+	const FPublishedSnapshot* Published = PublishedSnapshot.load();
+	FStdbCacheSnapshotPtr Snapshot = Published ? Published->Snapshot : nullptr;
+	NumSnapshotReaders.fetch_sub(1);
+	return Snapshot;
+}
+
+void FStdbClientCache::PublishSnapshot(TArray<FSnapshotChange>&& Changes)
+{
+	// Readers only care about tables they can see, nothing to publish if none of those changed
+	Changes.RemoveAllSwap([](const FSnapshotChange& Change) { return !Change.Table->HasSnapshots(); }, /* bAllowShrinking = */ false);
+	if (Changes.Num() == 0)
+	{
+		return;
+	}
+
+	SnapshotPipe.Launch(TEXT("FStdbBuildSnapshot"), [this, BuildVersion = Version, Changes = MoveTemp(Changes)]() mutable
+	{
+		// Holders that are gone make their buffers free to patch
+		FreeRetiredSnapshots();
+
+		TSharedRef<FStdbCacheSnapshot, ESPMode::ThreadSafe> Next = MakeShared<FStdbCacheSnapshot, ESPMode::ThreadSafe>();
+		Next->Version = BuildVersion;
+		Next->Tables = LastSnapshot->Tables;
+		for (FSnapshotChange& Change : Changes)
+		{
+			Next->Tables.Add(Change.Table->GetTableName(), Change.Table->BuildSnapshot(BuildVersion, MoveTemp(Change.Diff)));
+		}
+		SwapSnapshot(Next);
+	});
+}
+
+void FStdbClientCache::SwapSnapshot(FStdbCacheSnapshotPtr Next)
+{
+	LastSnapshot = Next;
+	FPublishedSnapshot* Previous = PublishedSnapshot.exchange(new FPublishedSnapshot{MoveTemp(Next)});
+	if (Previous)
+	{
+		RetiredSnapshots.Add(Previous);
+	}
+	FreeRetiredSnapshots();
+}
+
+void FStdbClientCache::FreeRetiredSnapshots()
+{
+	// A reader that loaded a retired holder counted itself in before, so none is left once the count is 0
+	if (RetiredSnapshots.Num() == 0 || NumSnapshotReaders.load() != 0)
+	{
+		return;
+	}
+	for (FPublishedSnapshot* Retired : RetiredSnapshots)
+	{
+		delete Retired;
+	}
+	RetiredSnapshots.Reset();
+}
+
+void FStdbClientCache::DecodeDatabaseUpdate(const FDatabaseUpdate& Update, FStdbCacheDiff& OutDiff) const
+{
+	DecodeTableUpdates(Update.Tables, OutDiff);
+}
+
+void FStdbClientCache::DecodeTableUpdate(const FTableUpdate& Update, FStdbCacheDiff& OutDiff) const
+{
+	DecodeTableUpdates(MakeArrayView(&Update, 1), OutDiff);
+}
+
+void FStdbClientCache::DecodeTableUpdates(TArrayView<const FTableUpdate> Updates, FStdbCacheDiff& OutDiff) const
+{
+	// A table can come up in several updates of one message, they all go into its diff
+	TArray<TArray<const FTableUpdate*, TInlineAllocator<1>>, TInlineAllocator<16>> UpdatesByTable;
+	UpdatesByTable.SetNum(OutDiff.Tables.Num());
+	uint64 NumRows = 0;
+	for (const FTableUpdate& Update : Updates)
+	{
+		IStdbTableCache* Table = ResolveTable(Update);
+		if (!Table)
+		{
+			continue;
+		}
+
+		int32 Index = OutDiff.Tables.IndexOfByPredicate(
+			[Table](const FStdbCacheDiff::FTableDiff& Existing) { return Existing.Table == Table; });
+		if (Index == INDEX_NONE)
+		{
+			Index = OutDiff.Tables.Num();
+			OutDiff.Tables.AddDefaulted_GetRef().Table = Table;
+			UpdatesByTable.AddDefaulted();
+		}
+		UpdatesByTable[Index].Add(&Update);
+		NumRows += Update.NumRows;
+	}
+
+	// Every table decodes into a diff of its own, so tables of big messages like InitialSubscription run in parallel
+	ParallelFor(OutDiff.Tables.Num(), [&OutDiff, &UpdatesByTable](int32 Index)
+	{
+		FStdbCacheDiff::FTableDiff& TableDiff = OutDiff.Tables[Index];
+		for (const FTableUpdate* Update : UpdatesByTable[Index])
+		{
+			TableDiff.Table->DecodeUpdate(*Update, TableDiff.Diff);
+		}
+		TableDiff.Table->FinishDiff(*TableDiff.Diff);
+	}, NumRows < MIN_PARALLEL_DECODE_ROWS);
+}
+
+void FStdbClientCache::ApplyDiff(FStdbCacheDiff& Diff)
+{
+	for (FStdbCacheDiff::FTableDiff& TableDiff : Diff.Tables)
+	{
+		TableDiff.Table->CommitDiff(*TableDiff.Diff);
+	}
+	++Version;
+
+	// Callbacks see the whole transaction applied
+	for (const FStdbCacheDiff::FTableDiff& TableDiff : Diff.Tables)
+	{
+		TableDiff.Table->BroadcastDiff(*TableDiff.Diff);
+	}
+
+	// The committed diffs are done with here, the snapshot pipe takes them over instead of copying tables
+	if (bRegistrationLocked)
+	{
+		TArray<FSnapshotChange> Changes;
+		Changes.Reserve(Diff.Tables.Num());
+		for (FStdbCacheDiff::FTableDiff& TableDiff : Diff.Tables)
+		{
+			Changes.Add({TableDiff.Table, MoveTemp(TableDiff.Diff)});
+		}
+		PublishSnapshot(MoveTemp(Changes));
+	}
+}
+
+void FStdbClientCache::ApplyDatabaseUpdate(const FDatabaseUpdate& Update)
+{
+	FStdbCacheDiff Diff;
+	DecodeDatabaseUpdate(Update, Diff);
+	ApplyDiff(Diff);
+}
+
+void FStdbClientCache::ApplyTableUpdate(const FTableUpdate& Update)
+{
+	FStdbCacheDiff Diff;
+	DecodeTableUpdate(Update, Diff);
+	ApplyDiff(Diff);
+}
+
+void FStdbClientCache::Clear()
+{
+	TArray<FSnapshotChange> Changes;
+	for (TPair<FString, TUniquePtr<IStdbTableCache>>& Pair : Tables)
+	{
+		Pair.Value->Clear();
+		Changes.Add({Pair.Value.Get(), nullptr});
+	}
+
+	// A reconnect may land on a republished module with different table ids
+	{
+		FWriteScopeLock Lock(TableIdLock);
+		TablesById.Reset();
+	}
+
+	++Version;
+	if (bRegistrationLocked)
+	{
+		PublishSnapshot(MoveTemp(Changes));
+	}
+}
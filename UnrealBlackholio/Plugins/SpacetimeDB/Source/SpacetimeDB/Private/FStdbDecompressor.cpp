@@ -0,0 +1,163 @@
+#include "FStdbDecompressor.h"
+
+#include "LogStdb.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+#if WITH_STDB_BROTLI
+#include "brotli/decode.h"
+#endif
+THIRD_PARTY_INCLUDES_END
+
+static const int64 MIN_OUTPUT_CHUNK = 16 * 1024;
+
+bool FStdbDecompressor::IsSupported(EStdbCompression Algo)
+{
+	switch (Algo)
+	{
+	case EStdbCompression::None:
+	case EStdbCompression::Gzip:
+		return true;
+	case EStdbCompression::Brotli:
+		return WITH_STDB_BROTLI != 0;
+	default:
+		return false;
+	}
+}
+
+bool FStdbDecompressor::Decompress(EStdbCompression Algo, TArrayView<const uint8> InData, TArray<uint8>& OutData)
+{
+	switch (Algo)
+	{
+	case EStdbCompression::None:
+		OutData.Append(InData.GetData(), InData.Num());
+		return true;
+	case EStdbCompression::Gzip:
+		return InflateGzip(InData, OutData);
+	case EStdbCompression::Brotli:
+		return DecompressBrotli(InData, OutData);
+	default:
+		UE_LOG(LogStdb, Error, TEXT("Unknown compression tag: %d"), static_cast<int32>(Algo));
+		return false;
+	}
+}
+
+bool FStdbDecompressor::GrowOutput(TArray<uint8>& OutData, int64 Written, int64 InputSize)
+{
+	const int64 Grow = FMath::Max3(Written, InputSize, MIN_OUTPUT_CHUNK);
+	const int64 NewSize = FMath::Min(static_cast<int64>(OutData.Num()) + Grow, MaxDecompressedSize);
+	if (NewSize <= OutData.Num())
+	{
+		UE_LOG(LogStdb, Error, TEXT("Decompressed payload exceeds %lld bytes"), MaxDecompressedSize);
+		return false;
+	}
+	OutData.SetNumUninitialized(static_cast<int32>(NewSize));
+	return true;
+}
+
+bool FStdbDecompressor::InflateGzip(TArrayView<const uint8> InData, TArray<uint8>& OutData)
+{
+	z_stream Stream;
+	FMemory::Memzero(Stream);
+	// 16 + MAX_WBITS: expect a gzip header and trailer rather than a raw zlib stream
+	if (inflateInit2(&Stream, 16 + MAX_WBITS) != Z_OK)
+	{
+		UE_LOG(LogStdb, Error, TEXT("Gzip: inflateInit2 failed"));
+		return false;
+	}
+
+	const int32 StartSize = OutData.Num();
+	int64 Written = StartSize;
+	Stream.next_in = const_cast<Bytef*>(InData.GetData());
+	Stream.avail_in = InData.Num();
+
+	bool bSuccess = false;
+	while (true)
+	{
+		if (Written == OutData.Num() && !GrowOutput(OutData, Written, InData.Num()))
+		{
+			break;
+		}
+
+		Stream.next_out = OutData.GetData() + Written;
+		Stream.avail_out = static_cast<uInt>(FMath::Min<int64>(OutData.Num() - Written, MAX_uint32));
+
+		const uInt AvailOutBefore = Stream.avail_out;
+		const int Result = inflate(&Stream, Z_NO_FLUSH);
+		Written += AvailOutBefore - Stream.avail_out;
+
+		if (Result == Z_STREAM_END)
+		{
+			bSuccess = true;
+			break;
+		}
+		if (Result == Z_BUF_ERROR && Stream.avail_in == 0 && Stream.avail_out > 0)
+		{
+			UE_LOG(LogStdb, Error, TEXT("Gzip: truncated stream"));
+			break;
+		}
+		if (Result != Z_OK && Result != Z_BUF_ERROR)
+		{
+			UE_LOG(LogStdb, Error, TEXT("Gzip: inflate failed (%d): %hs"), Result, Stream.msg ? Stream.msg : "");
+			break;
+		}
+	}
+
+	inflateEnd(&Stream);
+	OutData.SetNum(bSuccess ? static_cast<int32>(Written) : StartSize, /* bAllowShrinking = */ false);
+	return bSuccess;
+}
+
+bool FStdbDecompressor::DecompressBrotli(TArrayView<const uint8> InData, TArray<uint8>& OutData)
+{
+#if WITH_STDB_BROTLI
+	BrotliDecoderState* State = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+	if (!State)
+	{
+		UE_LOG(LogStdb, Error, TEXT("Brotli: failed to create decoder"));
+		return false;
+	}
+
+	const int32 StartSize = OutData.Num();
+	int64 Written = StartSize;
+	size_t AvailIn = InData.Num();
+	const uint8_t* NextIn = InData.GetData();
+
+	bool bSuccess = false;
+	while (true)
+	{
+		if (Written == OutData.Num() && !GrowOutput(OutData, Written, InData.Num()))
+		{
+			break;
+		}
+
+		size_t AvailOut = OutData.Num() - Written;
+		uint8_t* NextOut = OutData.GetData() + Written;
+		const BrotliDecoderResult Result = BrotliDecoderDecompressStream(State, &AvailIn, &NextIn, &AvailOut, &NextOut, nullptr);
+		Written = NextOut - OutData.GetData();
+
+		if (Result == BROTLI_DECODER_RESULT_SUCCESS)
+		{
+			bSuccess = true;
+			break;
+		}
+		if (Result == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT)
+		{
+			UE_LOG(LogStdb, Error, TEXT("Brotli: truncated stream"));
+			break;
+		}
+		if (Result == BROTLI_DECODER_RESULT_ERROR)
+		{
+			UE_LOG(LogStdb, Error, TEXT("Brotli: %hs"), BrotliDecoderErrorString(BrotliDecoderGetErrorCode(State)));
+			break;
+		}
+	}
+
+	BrotliDecoderDestroyInstance(State);
+	OutData.SetNum(bSuccess ? static_cast<int32>(Written) : StartSize, /* bAllowShrinking = */ false);
+	return bSuccess;
+#else
+	UE_LOG(LogStdb, Error, TEXT("Brotli compressed data received but the plugin was built without Brotli"));
+	return false;
+#endif
+}
@@ -0,0 +1,147 @@
+#include "FStdbMessageArena.h"
+
+static thread_local FStdbMessageArena* GCurrentStdbArena = nullptr;
+
+FStdbMessageArena::FStdbMessageArena(int64 InBlockSize)
+	: BlockSize(InBlockSize)
+{
+}
+
+FStdbMessageArena::~FStdbMessageArena()
+{
+	for (uint8* Block : Blocks)
+	{
+		FMemory::Free(Block);
+	}
+}
+
+void FStdbMessageArena::AddBlock(SIZE_T MinSize)
+{
+	// Allocations bigger than a block get a block of their own
+	const SIZE_T Size = FMath::Max<SIZE_T>(BlockSize, MinSize);
+	uint8* Block = static_cast<uint8*>(FMemory::Malloc(Size));
+	Blocks.Add(Block);
+	Cursor = Block;
+	End = Block + Size;
+}
+
+void* FStdbMessageArena::Allocate(SIZE_T Size, uint32 Alignment)
+{
+	Alignment = FMath::Max<uint32>(Alignment, 1);
+	uint8* Aligned = Align(Cursor, Alignment);
+	if (!Cursor || Aligned + Size > End)
+	{
+		AddBlock(Size + Alignment);
+		Aligned = Align(Cursor, Alignment);
+	}
+
+	Cursor = Aligned + Size;
+	BytesUsed += Size;
+	return Aligned;
+}
+
+bool FStdbMessageArena::TryGrowInPlace(void* Ptr, SIZE_T OldSize, SIZE_T NewSize)
+{
+	uint8* Start = static_cast<uint8*>(Ptr);
+	if (NewSize < OldSize || Start + OldSize != Cursor || Start + NewSize > End)
+	{
+		return false;
+	}
+
+	Cursor = Start + NewSize;
+	BytesUsed += NewSize - OldSize;
+	return true;
+}
+
+FStdbMessageArena& FStdbMessageArena::CreateChild()
+{
+	FScopeLock Lock(&ChildLock);
+	return *Children.Add_GetRef(MakeUnique<FStdbMessageArena>(BlockSize));
+}
+
+SIZE_T FStdbMessageArena::GetBytesUsed() const
+{
+	SIZE_T Total = BytesUsed;
+	FScopeLock Lock(&ChildLock);
+	for (const TUniquePtr<FStdbMessageArena>& Child : Children)
+	{
+		Total += Child->GetBytesUsed();
+	}
+	return Total;
+}
+
+FStdbMessageArena* FStdbMessageArena::GetCurrent()
+{
+	return GCurrentStdbArena;
+}
+
+void FStdbMessageArena::SetCurrent(FStdbMessageArena* Arena)
+{
+	GCurrentStdbArena = Arena;
+}
+
+FStdbArenaScope::FStdbArenaScope(FStdbMessageArena* Arena)
+	: Previous(FStdbMessageArena::GetCurrent())
+{
+	FStdbMessageArena::SetCurrent(Arena);
+}
+
+FStdbArenaScope::~FStdbArenaScope()
+{
+	FStdbMessageArena::SetCurrent(Previous);
+}
+
+void FStdbArenaAllocator::ForAnyElementType::MoveToEmpty(ForAnyElementType& Other)
+{
+	check(this != &Other);
+
+	if (Data && !Arena)
+	{
+		FMemory::Free(Data);
+	}
+
+	// The memory keeps belonging to wherever it came from
+	Data = Other.Data;
+	Arena = Other.Arena;
+	AllocatedBytes = Other.AllocatedBytes;
+	Other.Data = nullptr;
+	Other.AllocatedBytes = 0;
+}
+
+void FStdbArenaAllocator::ForAnyElementType::ResizeAllocation(SizeType CurrentNum, SizeType NewMax, SIZE_T NumBytesPerElement,
+                                                              uint32 AlignmentOfElement)
+{
+	const SIZE_T NewBytes = static_cast<SIZE_T>(NewMax) * NumBytesPerElement;
+	const uint32 Alignment = FMath::Max<uint32>(AlignmentOfElement, alignof(void*));
+
+	if (!Arena)
+	{
+		if (Data || NewMax)
+		{
+			Data = static_cast<FScriptContainerElement*>(FMemory::Realloc(Data, NewBytes, Alignment));
+		}
+		AllocatedBytes = NewBytes;
+		return;
+	}
+
+	if (NewMax == 0)
+	{
+		Data = nullptr;
+		AllocatedBytes = 0;
+		return;
+	}
+
+	if (Data && Arena->TryGrowInPlace(Data, AllocatedBytes, NewBytes))
+	{
+		AllocatedBytes = NewBytes;
+		return;
+	}
+
+	void* NewData = Arena->Allocate(NewBytes, Alignment);
+	if (Data)
+	{
+		FMemory::Memcpy(NewData, Data, FMath::Min(static_cast<SIZE_T>(CurrentNum) * NumBytesPerElement, NewBytes));
+	}
+	Data = static_cast<FScriptContainerElement*>(NewData);
+	AllocatedBytes = NewBytes;
+}
@@ -0,0 +1,140 @@
+#include "FStdbSender.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+
+// How long a batch waits before retrying when the connection isn't ready
+static const double SEND_RETRY_INTERVAL_MS = 50.0;
+
+FStdbSender::FStdbSender(FSendFrame InSendFrame, uint32 InQueueCapacity)
+	: SendFrame(MoveTemp(InSendFrame))
+	  , OutboundQueue(InQueueCapacity)
+	  , bStop(false)
+{
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Batch.Reserve(OutboundQueue.GetCapacity());
+}
+
+FStdbSender::~FStdbSender()
+{
+	Shutdown();
+
+	if (WakeEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+	}
+}
+
+void FStdbSender::Start(const FString& ThreadName)
+{
+	if (Thread)
+		return;
+
+	bStop = false;
+	Thread = FRunnableThread::Create(this, *ThreadName, 0, TPri_AboveNormal);
+}
+
+void FStdbSender::Shutdown()
+{
+	if (!Thread)
+		return;
+
+	Stop();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+}
+
+bool FStdbSender::TryEnqueue(FStdbSharedBuffer& Frame, FName CoalesceKey)
+{
+	if (!OutboundQueue.TryEnqueue(MoveTemp(Frame), CoalesceKey))
+	{
+		// Most likely the sender is waiting on the connection, keep nudging it
+		WakeEvent->Trigger();
+		return false;
+	}
+	WakeEvent->Trigger();
+	return true;
+}
+
+void FStdbSender::Wake()
+{
+	WakeEvent->Trigger();
+}
+
+uint32 FStdbSender::Run()
+{
+	while (!bStop)
+	{
+		DrainIntoBatch();
+
+		if (!SendBatch())
+		{
+			// The connection isn't up, keep the batch and retry
+			WakeEvent->Wait(FTimespan::FromMilliseconds(SEND_RETRY_INTERVAL_MS));
+			continue;
+		}
+
+		// A full batch left frames in the queue, their wake-ups may already be used up
+		if (!OutboundQueue.IsEmpty())
+		{
+			continue;
+		}
+		WakeEvent->Wait();
+	}
+	return 0;
+}
+
+void FStdbSender::Stop()
+{
+	bStop = true;
+	if (WakeEvent) WakeEvent->Trigger();
+}
+
+void FStdbSender::DrainIntoBatch()
+{
+	// The batch holds at most one queue's worth of frames. While the connection is down the
+	// queue fills up behind it and TryEnqueue refuses frames instead of the batch growing
+	FOutboundFrame Frame;
+	while (Batch.Num() < OutboundQueue.GetCapacity() && OutboundQueue.Dequeue(Frame))
+	{
+		if (!Frame.CoalesceKey.IsNone())
+		{
+			// The superseded frame is dropped where it was and the newer one goes to the back,
+			// so it stays ordered after everything that was enqueued before it
+			if (int32* Slot = CoalesceSlots.Find(Frame.CoalesceKey))
+			{
+				if (*Slot >= NumSent)
+				{
+					Batch[*Slot].Bytes.Reset();
+				}
+				*Slot = Batch.Num();
+			}
+			else
+			{
+				CoalesceSlots.Add(Frame.CoalesceKey, Batch.Num());
+			}
+		}
+		Batch.Add(MoveTemp(Frame));
+	}
+}
+
+bool FStdbSender::SendBatch()
+{
+	for (; NumSent < Batch.Num(); ++NumSent)
+	{
+		const FOutboundFrame& Frame = Batch[NumSent];
+		if (Frame.Bytes.IsValid() && !SendFrame(*Frame.Bytes))
+		{
+			return false;
+		}
+	}
+
+	// Frames go back to the buffer pool here
+	Batch.Reset();
+	NumSent = 0;
+	CoalesceSlots.Reset();
+	return true;
+}
@@ -0,0 +1,192 @@
+#include "FStdbSubscriptionManager.h"
+
+#include "LogStdb.h"
+
+FStdbSubscriptionManager::FStdbSubscriptionManager(FSendMessage InSendMessage)
+	: SendMessage(MoveTemp(InSendMessage))
+{
+}
+
+FQueryId FStdbSubscriptionManager::Subscribe(const TArray<FString>& Queries, FOnApplied OnApplied, FOnError OnError)
+{
+	const FQueryId QueryId(NextQueryId);
+	const uint32 RequestId = NextRequestId++;
+	if (!SendMessage(FClientMessage::SubscribeMulti(FSubscribeMultiData(Queries, RequestId, QueryId))))
+	{
+		UE_LOG(LogStdb, Warning, TEXT("Outbound queue is full, dropping subscription to %d queries"), Queries.Num());
+		return FQueryId();
+	}
+	++NextQueryId;
+
+	FSubscription& Subscription = Subscriptions.Add(QueryId.Id);
+	Subscription.Queries = Queries;
+	Subscription.RequestId = RequestId;
+	Subscription.OnApplied = MoveTemp(OnApplied);
+	Subscription.OnError = MoveTemp(OnError);
+	QueryIdByRequestId.Add(RequestId, QueryId.Id);
+	return QueryId;
+}
+
+bool FStdbSubscriptionManager::Unsubscribe(FQueryId QueryId, FOnEnded OnEnded)
+{
+	FSubscription* Subscription = Subscriptions.Find(QueryId.Id);
+	if (!Subscription || Subscription->State == EStdbSubscriptionState::Unsubscribing)
+	{
+		return false;
+	}
+
+	switch (Subscription->State)
+	{
+	case EStdbSubscriptionState::Error:
+		{
+			Subscriptions.Remove(QueryId.Id);
+			OnEnded.ExecuteIfBound(QueryId);
+			return true;
+		}
+	case EStdbSubscriptionState::Pending:
+		// The server doesn't know the query id until it answers the subscribe
+		Subscription->bUnsubscribeWhenApplied = true;
+		break;
+	default:
+		if (!SendUnsubscribe(QueryId))
+		{
+			return false;
+		}
+		break;
+	}
+
+	Subscription->State = EStdbSubscriptionState::Unsubscribing;
+	Subscription->OnEnded = MoveTemp(OnEnded);
+	return true;
+}
+
+EStdbSubscriptionState FStdbSubscriptionManager::GetState(FQueryId QueryId) const
+{
+	const FSubscription* Subscription = Subscriptions.Find(QueryId.Id);
+	return Subscription ? Subscription->State : EStdbSubscriptionState::None;
+}
+
+const TArray<FString>* FStdbSubscriptionManager::GetQueries(FQueryId QueryId) const
+{
+	const FSubscription* Subscription = Subscriptions.Find(QueryId.Id);
+	return Subscription ? &Subscription->Queries : nullptr;
+}
+
+FString FStdbSubscriptionManager::GetError(FQueryId QueryId) const
+{
+	const FSubscription* Subscription = Subscriptions.Find(QueryId.Id);
+	return Subscription ? Subscription->Error : FString();
+}
+
+void FStdbSubscriptionManager::HandleSubscribeMultiApplied(const FSubscribeMultiAppliedData& Data)
+{
+	QueryIdByRequestId.Remove(Data.RequestId);
+
+	FSubscription* Subscription = Subscriptions.Find(Data.QueryId.Id);
+	if (!Subscription)
+	{
+		UE_LOG(LogStdb, Warning, TEXT("SubscribeMultiApplied for unknown query id %u"), Data.QueryId.Id);
+		return;
+	}
+
+	UE_LOG(LogStdb, Verbose, TEXT("Subscription %u applied in %llu us"), Data.QueryId.Id, Data.TotalHostExecutionDurationMicros);
+
+	if (Subscription->bUnsubscribeWhenApplied)
+	{
+		Subscription->bUnsubscribeWhenApplied = false;
+		if (SendUnsubscribe(Data.QueryId))
+		{
+			return;
+		}
+		UE_LOG(LogStdb, Warning, TEXT("Could not unsubscribe %u once applied, it stays subscribed"), Data.QueryId.Id);
+		Subscription->OnEnded.Unbind();
+	}
+
+	Subscription->State = EStdbSubscriptionState::Applied;
+
+	// Copied out, the callback may subscribe again and move the entry
+	const FOnApplied OnApplied = Subscription->OnApplied;
+	OnApplied.ExecuteIfBound(Data.QueryId);
+}
+
+void FStdbSubscriptionManager::HandleUnsubscribeMultiApplied(const FUnsubscribeMultiAppliedData& Data)
+{
+	FSubscription Subscription;
+	if (!Subscriptions.RemoveAndCopyValue(Data.QueryId.Id, Subscription))
+	{
+		UE_LOG(LogStdb, Warning, TEXT("UnsubscribeMultiApplied for unknown query id %u"), Data.QueryId.Id);
+		return;
+	}
+	Subscription.OnEnded.ExecuteIfBound(Data.QueryId);
+}
+
+void FStdbSubscriptionManager::HandleSubscriptionError(const FSubscriptionErrorData& Data)
+{
+	// Without either id the error isn't tied to one set, the server dropped all of them
+	if (!Data.QueryId.IsSet() && !Data.RequestId.IsSet())
+	{
+		UE_LOG(LogStdb, Error, TEXT("Subscriptions failed: %s"), *Data.Error);
+		TArray<uint32> QueryIds;
+		Subscriptions.GetKeys(QueryIds);
+		for (uint32 QueryId : QueryIds)
+		{
+			FailSubscription(QueryId, Data.Error);
+		}
+		return;
+	}
+
+	uint32 QueryId = Data.QueryId.Get(0);
+	if (!Data.QueryId.IsSet())
+	{
+		QueryIdByRequestId.RemoveAndCopyValue(Data.RequestId.GetValue(), QueryId);
+	}
+
+	if (!Subscriptions.Contains(QueryId))
+	{
+		UE_LOG(LogStdb, Warning, TEXT("Subscription error for unknown query id %u: %s"), QueryId, *Data.Error);
+		return;
+	}
+	FailSubscription(QueryId, Data.Error);
+}
+
+void FStdbSubscriptionManager::Reset()
+{
+	Subscriptions.Reset();
+	QueryIdByRequestId.Reset();
+}
+
+bool FStdbSubscriptionManager::SendUnsubscribe(FQueryId QueryId)
+{
+	if (!SendMessage(FClientMessage::UnsubscribeMulti(FUnsubscribeMultiData(NextRequestId++, QueryId))))
+	{
+		UE_LOG(LogStdb, Warning, TEXT("Outbound queue is full, could not unsubscribe %u"), QueryId.Id);
+		return false;
+	}
+	return true;
+}
+
+void FStdbSubscriptionManager::FailSubscription(uint32 QueryId, const FString& Error)
+{
+	FSubscription* Subscription = Subscriptions.Find(QueryId);
+	if (!Subscription || Subscription->State == EStdbSubscriptionState::Error)
+	{
+		return;
+	}
+	UE_LOG(LogStdb, Warning, TEXT("Subscription %u failed: %s"), QueryId, *Error);
+	QueryIdByRequestId.Remove(Subscription->RequestId);
+
+	// Already on its way out, the server dropping it ends it just the same
+	if (Subscription->State == EStdbSubscriptionState::Unsubscribing)
+	{
+		FSubscription Ended;
+		Subscriptions.RemoveAndCopyValue(QueryId, Ended);
+		Ended.OnEnded.ExecuteIfBound(FQueryId(QueryId));
+		return;
+	}
+
+	// Rows the set already brought in stay cached until the cache is cleared
+	Subscription->State = EStdbSubscriptionState::Error;
+	Subscription->Error = Error;
+	const FOnError OnError = Subscription->OnError;
+	OnError.ExecuteIfBound(FQueryId(QueryId), Error);
+}
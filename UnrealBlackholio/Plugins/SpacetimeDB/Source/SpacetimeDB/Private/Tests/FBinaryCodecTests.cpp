@@ -0,0 +1,294 @@
+#include "Misc/AutomationTest.h"
+#include "FBinaryReader.h"
+#include "FBinaryWriter.h"
+#include "ClientApi/FServerMessage.h"
+#include "ClientCache/FStdbClientCache.h"
+#include "Tests/StdbBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	TArray<uint64> MakeOffsets(int32 Num)
+	{
+		TArray<uint64> Offsets;
+		Offsets.Reserve(Num);
+		for (int32 i = 0; i < Num; ++i)
+		{
+			Offsets.Add(static_cast<uint64>(i) * 16 + 0x0102030405060708ull);
+		}
+		return Offsets;
+	}
+
+	TArrayView<const uint8> Written(const FBinaryWriter& Writer)
+	{
+		return MakeArrayView(Writer.GetData().GetData(), static_cast<int32>(Writer.GetPosition()));
+	}
+
+	bool SameBytes(TArrayView<const uint8> A, TArrayView<const uint8> B)
+	{
+		return A.Num() == B.Num() && FMemory::Memcmp(A.GetData(), B.GetData(), A.Num()) == 0;
+	}
+
+	/**
+	 * Writes an InitialSubscription body as the server does: NumTables tables of RowsPerTable
+	 * inserted rows of RowSize bytes, delimited by RowOffsets
+	 */
+	void WriteInitialSubscription(FBinaryWriter& Writer, int32 NumTables, int32 RowsPerTable, int32 RowSize)
+	{
+		TArray<uint64> Offsets;
+		Offsets.SetNumUninitialized(RowsPerTable);
+		for (int32 i = 0; i < RowsPerTable; ++i)
+		{
+			Offsets[i] = static_cast<uint64>(i) * RowSize;
+		}
+		TArray<uint8> Rows;
+		Rows.SetNumUninitialized(RowsPerTable * RowSize);
+		for (int32 i = 0; i < Rows.Num(); ++i)
+		{
+			Rows[i] = static_cast<uint8>(i * 31);
+		}
+
+		Writer.WriteInt32(NumTables);
+		for (int32 Table = 0; Table < NumTables; ++Table)
+		{
+			Writer.WriteUInt32(Table + 1);
+			Writer.WriteString(FString::Printf(TEXT("table_%d"), Table));
+			Writer.WriteUInt64(RowsPerTable);
+			// One uncompressed query update: no deletes, then the inserts
+			Writer.WriteInt32(1);
+			Writer.WriteByte(0);
+			Writer.WriteByte(1);
+			Writer.WritePrimitiveArray(TArray<uint64>());
+			Writer.WritePrimitiveArray(TArray<uint8>());
+			Writer.WriteByte(1);
+			Writer.WritePrimitiveArray(Offsets);
+			Writer.WritePrimitiveArray(Rows);
+		}
+		Writer.WriteUInt32(1);
+		Writer.WriteTimeDuration(FTimeDuration());
+	}
+
+	// The 24 byte rows WriteInitialSubscription fills its tables with
+	struct FWideRow
+	{
+		using FPrimaryKey = uint64;
+
+		uint64 A = 0;
+		uint64 B = 0;
+		uint64 C = 0;
+
+		FPrimaryKey GetPrimaryKey() const { return A; }
+
+		STDB_BSATN_FIELDS(A, B, C)
+	};
+
+	/** The same message read the way the codec did before the bulk path, every array element through a TFunction */
+	int64 ReadInitialSubscriptionPerElement(FBinaryReader& Reader)
+	{
+		int64 NumBytes = 0;
+		const auto ReadRowList = [&Reader, &NumBytes]
+		{
+			if (Reader.ReadByte() == 0)
+			{
+				Reader.ReadUInt16();
+			}
+			else
+			{
+				NumBytes += Reader.ReadArray<uint64>([](FBinaryReader& R) { return R.ReadUInt64(); }).Num() * static_cast<int64>(sizeof(uint64));
+			}
+			NumBytes += Reader.ReadArray<uint8>([](FBinaryReader& R) { return R.ReadByte(); }).Num();
+		};
+
+		const int32 NumTables = Reader.ReadInt32();
+		for (int32 Table = 0; Table < NumTables; ++Table)
+		{
+			Reader.ReadUInt32();
+			Reader.ReadString();
+			Reader.ReadUInt64();
+			const int32 NumUpdates = Reader.ReadInt32();
+			for (int32 Update = 0; Update < NumUpdates; ++Update)
+			{
+				Reader.ReadByte();
+				ReadRowList();
+				ReadRowList();
+			}
+		}
+		Reader.ReadUInt32();
+		Reader.ReadTimeDuration();
+		return NumBytes;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbPrimitiveArrayRoundTripTest, "SpacetimeDB.Codec.PrimitiveArrayRoundTrip", STDB_TEST_FLAGS)
+
+bool FStdbPrimitiveArrayRoundTripTest::RunTest(const FString& Parameters)
+{
+	const TArray<uint64> Offsets = MakeOffsets(1000);
+
+	FBinaryWriter Bulk;
+	Bulk.WritePrimitiveArray(Offsets);
+	FBinaryWriter PerElement;
+	PerElement.WriteArray<uint64>(Offsets, [](FBinaryWriter& W, const uint64& V) { W.WriteUInt64(V); });
+	TestTrue(TEXT("Bulk and per element writes produce the same bytes"), SameBytes(Written(Bulk), Written(PerElement)));
+
+	FBinaryReader Reader(Written(Bulk));
+	TestTrue(TEXT("Bulk read returns the written array"), Reader.ReadPrimitiveArray<uint64>() == Offsets);
+	TestEqual(TEXT("Bulk read consumes the whole array"), Reader.GetPosition(), Reader.GetSize());
+
+	FBinaryWriter Empty;
+	Empty.WritePrimitiveArray(TArray<uint64>());
+	FBinaryReader EmptyReader(Written(Empty));
+	TestEqual(TEXT("Empty array round trips"), EmptyReader.ReadPrimitiveArray<uint64>().Num(), 0);
+
+	// A whole message decodes to what was written
+	FBinaryWriter Message;
+	WriteInitialSubscription(Message, 2, 100, 24);
+	FBinaryReader MessageReader(Written(Message));
+	FInitialSubscriptionData Data;
+	Data.ReadFields(MessageReader);
+	TestEqual(TEXT("Message is read to the end"), MessageReader.GetPosition(), MessageReader.GetSize());
+	TestEqual(TEXT("Every table is read"), static_cast<int32>(Data.DatabaseUpdate.Tables.Num()), 2);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbRowListBoundsTest, "SpacetimeDB.Codec.RowListBounds", STDB_TEST_FLAGS)
+
+bool FStdbRowListBoundsTest::RunTest(const FString& Parameters)
+{
+	const TArray<uint8> Rows = {1, 2, 3, 4, 5, 6, 7, 8};
+	const auto ReadOffsetsList = [&Rows](const TArray<uint64>& Offsets)
+	{
+		FBinaryWriter Writer;
+		Writer.WriteByte(1);
+		Writer.WritePrimitiveArray(Offsets);
+		Writer.WritePrimitiveArray(Rows);
+		FBinaryReader Reader(Written(Writer));
+		FBsatnRowList List;
+		List.ReadFields(Reader);
+		return List;
+	};
+
+	const FBsatnRowList Valid = ReadOffsetsList({0, 3, 3, 8});
+	TestTrue(TEXT("Ascending offsets inside the rows are accepted"), !Valid.bMalformed && Valid.Num() == 4 && Valid.GetRow(2).Size == 0);
+
+	const FBsatnRowList Descending = ReadOffsetsList({0, 5, 3});
+	TestTrue(TEXT("Descending offsets are malformed"), Descending.bMalformed && Descending.Num() == 0);
+
+	const FBsatnRowList PastEnd = ReadOffsetsList({0, 9});
+	TestTrue(TEXT("Offsets past the rows are malformed"), PastEnd.bMalformed && PastEnd.Num() == 0);
+
+	FBinaryWriter Fixed;
+	Fixed.WriteByte(0);
+	Fixed.WriteUInt16(3);
+	Fixed.WritePrimitiveArray(Rows);
+	FBinaryReader FixedReader(Written(Fixed));
+	FBsatnRowList Partial;
+	Partial.ReadFields(FixedReader);
+	TestTrue(TEXT("Fixed-size rows that don't fill the bytes are malformed"), Partial.bMalformed && Partial.Num() == 0);
+
+	// A message with a malformed list fails as a whole
+	FBinaryWriter Message;
+	WriteInitialSubscription(Message, 2, 4, 8);
+	TArray<uint8> Bytes(Written(Message).GetData(), Written(Message).Num());
+	FBinaryReader GoodReader(Bytes);
+	FInitialSubscriptionData Good;
+	Good.ReadFields(GoodReader);
+	TestTrue(TEXT("Well formed message decodes"), Good.DatabaseUpdate.Decompress());
+
+	// Corrupt the last inserted row offset of the second table: 4 rows of 8 bytes are followed by the row bytes length
+	const int64 LastOffset = Bytes.Num() - 4 - 8 - (4 + 4 * 8) - 8;
+	const uint64 Corrupt = 1000;
+	FMemory::Memcpy(Bytes.GetData() + LastOffset, &Corrupt, sizeof(Corrupt));
+	FBinaryReader BadReader(Bytes);
+	FInitialSubscriptionData Bad;
+	Bad.ReadFields(BadReader);
+	TestFalse(TEXT("Message with malformed rows fails to decode"), Bad.DatabaseUpdate.Decompress());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbParallelTableDecodeTest, "SpacetimeDB.Codec.ParallelTableDecode", STDB_TEST_FLAGS)
+
+bool FStdbParallelTableDecodeTest::RunTest(const FString& Parameters)
+{
+	FStdbClientCache Cache;
+	Cache.RegisterTable<FWideRow>(TEXT("table_0"));
+	Cache.RegisterTable<FWideRow>(TEXT("table_1"));
+	Cache.LockRegistration();
+
+	// Enough rows for the tables to be decoded in parallel, plus one the cache doesn't know
+	for (const int32 RowsPerTable : {3, 8192})
+	{
+		FBinaryWriter Message;
+		WriteInitialSubscription(Message, 3, RowsPerTable, 24);
+		FBinaryReader Reader(Written(Message));
+		FInitialSubscriptionData Data;
+		Data.ReadFields(Reader);
+
+		FStdbCacheDiff Diff;
+		Cache.DecodeDatabaseUpdate(Data.DatabaseUpdate, Diff);
+		bool bAllDecoded = Diff.Tables.Num() == 2;
+		for (const FStdbCacheDiff::FTableDiff& TableDiff : Diff.Tables)
+		{
+			const TStdbTableDiff<FWideRow>& Rows = static_cast<const TStdbTableDiff<FWideRow>&>(*TableDiff.Diff);
+			bAllDecoded &= Rows.Inserts.Num() == RowsPerTable && Rows.Deletes.Num() == 0;
+		}
+		TestTrue(FString::Printf(TEXT("Every registered table decodes its %d rows"), RowsPerTable), bAllDecoded);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbPrimitiveArrayBenchmark, "SpacetimeDB.Benchmark.PrimitiveArrays", STDB_BENCHMARK_FLAGS)
+
+bool FStdbPrimitiveArrayBenchmark::RunTest(const FString& Parameters)
+{
+	// 64 MB of InitialSubscription: 4 tables of 512k rows, 24 byte rows plus an 8 byte offset each
+	const int32 NumTables = 4;
+	const int32 RowsPerTable = 512 * 1024;
+	const int32 RowSize = 24;
+	FBinaryWriter Encoded(static_cast<int64>(NumTables) * RowsPerTable * (RowSize + static_cast<int64>(sizeof(uint64))) + 4096);
+	WriteInitialSubscription(Encoded, NumTables, RowsPerTable, RowSize);
+	const TArrayView<const uint8> Bytes = Written(Encoded);
+
+	int64 PerElementBytes = 0;
+	const double PerElementRead = StdbBenchmark::TimeBest(3, [&]
+	{
+		FBinaryReader Reader(Bytes);
+		PerElementBytes = ReadInitialSubscriptionPerElement(Reader);
+	});
+
+	int64 BulkPosition = 0;
+	const double BulkRead = StdbBenchmark::TimeBest(3, [&]
+	{
+		FBinaryReader Reader(Bytes);
+		FInitialSubscriptionData Data;
+		Data.ReadFields(Reader);
+		BulkPosition = Reader.GetPosition();
+	});
+	TestEqual(TEXT("Both reads consume the whole message"), BulkPosition, static_cast<int64>(Bytes.Num()));
+	TestEqual(TEXT("Per element read sees every row and offset"), PerElementBytes,
+	          static_cast<int64>(NumTables * RowsPerTable * (RowSize + static_cast<int32>(sizeof(uint64)))));
+	StdbBenchmark::ReportThroughput(*this, TEXT("Decode 64 MB InitialSubscription"), Bytes.Num(), TEXT("per element"),
+	                                PerElementRead, TEXT("bulk"), BulkRead);
+
+	const TArray<uint64> Offsets = MakeOffsets(1 << 20);
+	FBinaryWriter Writer(static_cast<int64>(Offsets.Num()) * sizeof(uint64) + 16);
+	const double PerElementWrite = StdbBenchmark::TimeBest(5, [&]
+	{
+		Writer.Reset();
+		Writer.WriteArray<uint64>(Offsets, [](FBinaryWriter& W, const uint64& V) { W.WriteUInt64(V); });
+	});
+	FBinaryWriter PerElementEncoded;
+	PerElementEncoded.WriteArray<uint64>(Offsets, [](FBinaryWriter& W, const uint64& V) { W.WriteUInt64(V); });
+	const double BulkWrite = StdbBenchmark::TimeBest(5, [&]
+	{
+		Writer.Reset();
+		Writer.WritePrimitiveArray(Offsets);
+	});
+	TestTrue(TEXT("Bulk write matches the per element encoding"), SameBytes(Written(Writer), Written(PerElementEncoded)));
+	StdbBenchmark::ReportThroughput(*this, TEXT("Encode 8 MB of u64"), Written(Writer).Num(), TEXT("per element"),
+	                                PerElementWrite, TEXT("bulk"), BulkWrite);
+	return true;
+}
+
+#endif
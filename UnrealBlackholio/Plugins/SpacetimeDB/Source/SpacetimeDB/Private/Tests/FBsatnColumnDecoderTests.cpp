@@ -0,0 +1,163 @@
+#include "Misc/AutomationTest.h"
+#include "ClientApi/FBsatnColumnDecoder.h"
+#include "Tests/StdbBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	struct FTestVector2
+	{
+		float X = 0.f;
+		float Y = 0.f;
+
+		bool operator==(const FTestVector2& Other) const { return X == Other.X && Y == Other.Y; }
+	};
+
+	// A 16 byte row of a u32, an f32 pair and a u32, the layout the vector path takes
+	struct FTestColumns
+	{
+		TArray<uint32> Ids;
+		TArray<FTestVector2> Pairs;
+		TArray<uint32> Counts;
+	};
+
+	// The same row as a struct, decoded in place through strided columns
+	struct FTestRow
+	{
+		uint32 Id = 0;
+		FTestVector2 Pair;
+		uint32 Count = 0;
+	};
+
+	TArray<uint8> MakeRows(int32 NumRows)
+	{
+		TArray<uint8> Bytes;
+		FBinaryWriter Writer(Bytes);
+		for (int32 i = 0; i < NumRows; ++i)
+		{
+			Writer.WriteUInt32(1000 + i);
+			Writer.WriteFloat(i * 0.5f);
+			Writer.WriteFloat(-i * 0.25f);
+			Writer.WriteUInt32(i % 97);
+		}
+		return Bytes;
+	}
+
+	FBsatnRowList MakeFixedRowList(TArrayView<const uint8> Bytes, uint16 RowSize)
+	{
+		FBsatnRowList Rows;
+		Rows.SizeHint.Type = RowSizeHint::EHintType::FixedSize;
+		Rows.SizeHint.SizeHint.Emplace<uint16>(RowSize);
+		Rows.RowsData = Bytes;
+		return Rows;
+	}
+
+	bool DecodeColumns(const FBsatnRowList& Rows, FTestColumns& Out)
+	{
+		const int32 NumRows = Rows.Num();
+		const FBsatnColumn Columns[] = {
+			FBsatnColumnDecoder::AppendColumn(0, Out.Ids, NumRows),
+			FBsatnColumnDecoder::AppendColumn(4, Out.Pairs, NumRows),
+			FBsatnColumnDecoder::AppendColumn(12, Out.Counts, NumRows)
+		};
+		return FBsatnColumnDecoder::DecodeFixedRows(Rows, Columns);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbColumnDecoderTransposeTest, "SpacetimeDB.Codec.ColumnDecoderTranspose", STDB_TEST_FLAGS)
+
+bool FStdbColumnDecoderTransposeTest::RunTest(const FString& Parameters)
+{
+	// Not a multiple of four, the last rows take the scalar path after the transposed ones
+	for (const int32 NumRows : {0, 1, 4, 7, 1027})
+	{
+		const TArray<uint8> Bytes = MakeRows(NumRows);
+		FTestColumns Columns;
+		if (!TestTrue(FString::Printf(TEXT("%d rows decode"), NumRows), DecodeColumns(MakeFixedRowList(Bytes, 16), Columns)))
+		{
+			continue;
+		}
+
+		bool bAllMatch = Columns.Ids.Num() == NumRows && Columns.Pairs.Num() == NumRows && Columns.Counts.Num() == NumRows;
+		for (int32 i = 0; bAllMatch && i < NumRows; ++i)
+		{
+			bAllMatch = Columns.Ids[i] == static_cast<uint32>(1000 + i)
+				&& Columns.Pairs[i] == FTestVector2{i * 0.5f, -i * 0.25f}
+				&& Columns.Counts[i] == static_cast<uint32>(i % 97);
+		}
+		TestTrue(FString::Printf(TEXT("%d rows land in their columns"), NumRows), bAllMatch);
+	}
+
+	// Two lane column in the upper half of the row, the lower lanes skipped
+	{
+		const TArray<uint8> Bytes = MakeRows(9);
+		TArray<uint64> Upper;
+		const FBsatnColumn Columns[] = {FBsatnColumnDecoder::AppendColumn(8, Upper, 9)};
+		TestTrue(TEXT("Upper lanes decode"), FBsatnColumnDecoder::DecodeFixedRows(MakeFixedRowList(Bytes, 16), Columns));
+		bool bAllMatch = true;
+		for (int32 i = 0; i < 9; ++i)
+		{
+			uint64 Expected;
+			FMemory::Memcpy(&Expected, Bytes.GetData() + i * 16 + 8, 8);
+			bAllMatch &= Upper[i] == Expected;
+		}
+		TestTrue(TEXT("Upper lanes keep their byte order"), bAllMatch);
+	}
+
+	// Fields written straight into row structs
+	for (const int32 NumRows : {1, 7})
+	{
+		const TArray<uint8> Bytes = MakeRows(NumRows);
+		TArray<FTestRow> Rows;
+		Rows.SetNum(NumRows);
+		const FBsatnColumn Columns[] = {
+			FBsatnColumnDecoder::FieldColumn(0, Rows.GetData(), &FTestRow::Id),
+			FBsatnColumnDecoder::FieldColumn(4, Rows.GetData(), &FTestRow::Pair),
+			FBsatnColumnDecoder::FieldColumn(12, Rows.GetData(), &FTestRow::Count)
+		};
+		TestTrue(FString::Printf(TEXT("%d rows decode into structs"), NumRows), FBsatnColumnDecoder::DecodeFixedRows(MakeFixedRowList(Bytes, 16), Columns));
+		bool bAllMatch = true;
+		for (int32 i = 0; i < NumRows; ++i)
+		{
+			bAllMatch &= Rows[i].Id == static_cast<uint32>(1000 + i)
+				&& Rows[i].Pair == FTestVector2{i * 0.5f, -i * 0.25f}
+				&& Rows[i].Count == static_cast<uint32>(i % 97);
+		}
+		TestTrue(FString::Printf(TEXT("%d rows land in their structs"), NumRows), bAllMatch);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbColumnDecoderRejectTest, "SpacetimeDB.Codec.ColumnDecoderReject", STDB_TEST_FLAGS)
+
+bool FStdbColumnDecoderRejectTest::RunTest(const FString& Parameters)
+{
+	const TArray<uint8> Bytes = MakeRows(4);
+
+	// Rows of a size the vector path doesn't handle still decode, one field at a time
+	{
+		TArray<uint8> Narrow;
+		const FBsatnColumn Columns[] = {FBsatnColumnDecoder::AppendColumn(3, Narrow, 8)};
+		TestTrue(TEXT("8 byte rows decode"), FBsatnColumnDecoder::DecodeFixedRows(MakeFixedRowList(Bytes, 8), Columns));
+		TestEqual(TEXT("Odd offsets copy the right byte"), static_cast<int32>(Narrow[1]), static_cast<int32>(Bytes[8 + 3]));
+	}
+
+	uint32 Untouched[4] = {7, 7, 7, 7};
+	const FBsatnColumn OutOfRow[] = {{14, 4, reinterpret_cast<uint8*>(Untouched)}};
+	TestFalse(TEXT("A column past the end of the row is refused"), FBsatnColumnDecoder::DecodeFixedRows(MakeFixedRowList(Bytes, 16), OutOfRow));
+	TestEqual(TEXT("Nothing is written when refused"), static_cast<int64>(Untouched[0]), static_cast<int64>(7));
+
+	const FBsatnColumn Overlapping[] = {{4, 8, reinterpret_cast<uint8*>(Untouched), 4}};
+	TestFalse(TEXT("A stride shorter than a value is refused"), FBsatnColumnDecoder::DecodeFixedRows(MakeFixedRowList(Bytes, 16), Overlapping));
+
+	FBsatnRowList Offsets;
+	Offsets.SizeHint.Type = RowSizeHint::EHintType::RowOffsets;
+	Offsets.SizeHint.SizeHint.Emplace<FStdbRowOffsets>();
+	Offsets.RowsData = Bytes;
+	const FBsatnColumn Ids[] = {{0, 4, reinterpret_cast<uint8*>(Untouched)}};
+	TestFalse(TEXT("Rows delimited by offsets are refused"), FBsatnColumnDecoder::DecodeFixedRows(Offsets, Ids));
+	return true;
+}
+
+#endif
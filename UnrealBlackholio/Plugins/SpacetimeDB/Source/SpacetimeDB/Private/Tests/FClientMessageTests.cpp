@@ -0,0 +1,157 @@
+#include "Misc/AutomationTest.h"
+#include "ClientApi/FClientMessage.h"
+#include "Tests/StdbBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// Shaped like the per frame input reducers: a few scalars and a short list
+	struct FBenchReducerArgs
+	{
+		float DirectionX = 0.f;
+		float DirectionY = 0.f;
+		FString Name;
+		TArray<uint32> EntityIds;
+
+		STDB_BSATN_FIELDS(DirectionX, DirectionY, Name, EntityIds)
+	};
+
+	FBenchReducerArgs MakeArgs(int32 Seed)
+	{
+		FBenchReducerArgs Args;
+		Args.DirectionX = Seed * 0.5f;
+		Args.DirectionY = -Seed * 0.25f;
+		Args.Name = FString::Printf(TEXT("player_%d"), Seed);
+		for (int32 i = 0; i < 8; ++i)
+		{
+			Args.EntityIds.Add(Seed * 8 + i);
+		}
+		return Args;
+	}
+
+	// How calls were encoded before: args into their own array, copied into the message, written through the growing writer
+	void SerializeTwoPass(const FString& Reducer, const FBenchReducerArgs& Args, uint32 RequestId, TArray<uint8>& Out)
+	{
+		TArray<uint8> ArgBytes;
+		FBinaryWriter ArgWriter(ArgBytes);
+		StdbBsatn::Write(ArgWriter, Args);
+
+		const FClientMessage Message = FClientMessage::CallReducer(FCallReducerData(Reducer, MoveTemp(ArgBytes), RequestId, 0));
+		FBinaryWriter Writer(Out);
+		Writer.WriteByte(static_cast<uint8>(Message.Type));
+		Message.Data.Get<FCallReducerData>().WriteFields(Writer);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbClientMessageRoundTripTest, "SpacetimeDB.Codec.ClientMessageRoundTrip", STDB_TEST_FLAGS)
+
+bool FStdbClientMessageRoundTripTest::RunTest(const FString& Parameters)
+{
+	const FString Reducer = TEXT("update_player_input");
+	const FBenchReducerArgs Args = MakeArgs(7);
+
+	TArray<uint8> OnePass;
+	FBinaryWriter Writer(OnePass);
+	FClientMessage::SerializeCallReducerArgs(Reducer, Args, 42, 0, Writer);
+
+	TArray<uint8> TwoPass;
+	SerializeTwoPass(Reducer, Args, 42, TwoPass);
+	TestTrue(TEXT("One pass encoding matches the two pass one byte for byte"), OnePass == TwoPass);
+
+	FBinaryReader Reader(OnePass);
+	const FClientMessage Decoded = FClientMessage::Deserialize(Reader);
+	TestTrue(TEXT("Decodes as a CallReducer"), Decoded.Type == EClientMessageType::CallReducer);
+	const FCallReducerData& Call = Decoded.Data.Get<FCallReducerData>();
+	TestEqual(TEXT("Reducer name"), Call.Reducer, Reducer);
+	TestEqual(TEXT("Request id"), static_cast<int64>(Call.RequestId), static_cast<int64>(42));
+	TestEqual(TEXT("Args length"), static_cast<int64>(Call.Args.Num()), StdbBsatn::Size(Args));
+
+	FBinaryReader ArgsReader(Call.Args);
+	FBenchReducerArgs DecodedArgs;
+	StdbBsatn::Read(ArgsReader, DecodedArgs);
+	TestEqual(TEXT("Args name"), DecodedArgs.Name, Args.Name);
+	TestTrue(TEXT("Args ids"), DecodedArgs.EntityIds == Args.EntityIds);
+
+	// Every message type goes through the variant path at the size it reports
+	const FClientMessage Subscribe = FClientMessage::SubscribeMulti(FSubscribeMultiData({TEXT("SELECT * FROM entity")}, 3, FQueryId(9)));
+	FBinaryWriter SubscribeWriter;
+	FClientMessage::Serialize(Subscribe, SubscribeWriter);
+	TestEqual(TEXT("SubscribeMulti is written at its encoded size"), SubscribeWriter.GetPosition(), FClientMessage::GetEncodedSize(Subscribe));
+
+	FBinaryReader SubscribeReader(MakeArrayView(SubscribeWriter.GetData().GetData(), static_cast<int32>(SubscribeWriter.GetPosition())));
+	const FClientMessage DecodedSubscribe = FClientMessage::Deserialize(SubscribeReader);
+	TestTrue(TEXT("SubscribeMulti round trips"), DecodedSubscribe.Type == EClientMessageType::SubscribeMulti
+		&& DecodedSubscribe.Data.Get<FSubscribeMultiData>().QueryId.Id == 9
+		&& DecodedSubscribe.Data.Get<FSubscribeMultiData>().QueryStrings == Subscribe.Data.Get<FSubscribeMultiData>().QueryStrings);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbClientMessageEncodeBenchmark, "SpacetimeDB.Benchmark.ClientMessageEncode", STDB_BENCHMARK_FLAGS)
+
+bool FStdbClientMessageEncodeBenchmark::RunTest(const FString& Parameters)
+{
+	const FString Reducer = TEXT("update_player_input");
+	const int32 NumCalls = 100000;
+	TArray<FBenchReducerArgs> Calls;
+	for (int32 i = 0; i < NumCalls; ++i)
+	{
+		Calls.Add(MakeArgs(i));
+	}
+
+	// The sender reuses pooled buffers, so does the benchmark
+	TArray<uint8> Buffer;
+	Buffer.Reserve(256);
+	int64 TwoPassBytes = 0;
+	const double TwoPass = StdbBenchmark::TimeBest(5, [&]
+	{
+		TwoPassBytes = 0;
+		for (int32 i = 0; i < NumCalls; ++i)
+		{
+			Buffer.Reset();
+			SerializeTwoPass(Reducer, Calls[i], i, Buffer);
+			TwoPassBytes += Buffer.Num();
+		}
+	});
+
+	int64 OnePassBytes = 0;
+	const double OnePass = StdbBenchmark::TimeBest(5, [&]
+	{
+		OnePassBytes = 0;
+		for (int32 i = 0; i < NumCalls; ++i)
+		{
+			Buffer.Reset();
+			FBinaryWriter Writer(Buffer);
+			FClientMessage::SerializeCallReducerArgs(Reducer, Calls[i], i, 0, Writer);
+			OnePassBytes += Buffer.Num();
+		}
+	});
+
+	TestEqual(TEXT("Both encodings write the same number of bytes"), OnePassBytes, TwoPassBytes);
+	StdbBenchmark::Report(*this, TEXT("Encode 100k reducer calls"), TEXT("two pass"), TwoPass, TEXT("one pass"), OnePass);
+
+	// Same loops once more, counting what they allocate instead of timing them
+	const int64 TwoPassAllocations = StdbBenchmark::CountAllocations([&]
+	{
+		for (int32 i = 0; i < NumCalls; ++i)
+		{
+			Buffer.Reset();
+			SerializeTwoPass(Reducer, Calls[i], i, Buffer);
+		}
+	});
+	const int64 OnePassAllocations = StdbBenchmark::CountAllocations([&]
+	{
+		for (int32 i = 0; i < NumCalls; ++i)
+		{
+			Buffer.Reset();
+			FBinaryWriter Writer(Buffer);
+			FClientMessage::SerializeCallReducerArgs(Reducer, Calls[i], i, 0, Writer);
+		}
+	});
+	AddInfo(FString::Printf(TEXT("Allocations per reducer call: two pass %.2f, one pass %.2f"),
+	                        static_cast<double>(TwoPassAllocations) / NumCalls, static_cast<double>(OnePassAllocations) / NumCalls));
+	TestTrue(TEXT("One pass allocates no more than two pass"), OnePassAllocations <= TwoPassAllocations);
+	return true;
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "Misc/AutomationTest.h"
+#include "FStdbMessageArena.h"
+#include "Tests/StdbBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbMessageArenaAllocateTest, "SpacetimeDB.Arena.Allocate", STDB_TEST_FLAGS)
+
+bool FStdbMessageArenaAllocateTest::RunTest(const FString& Parameters)
+{
+	FStdbMessageArena Arena(1024);
+
+	void* Byte = Arena.Allocate(1, 1);
+	void* Aligned = Arena.Allocate(24, 64);
+	TestNotNull(TEXT("Allocates"), Byte);
+	TestTrue(TEXT("Honours the alignment"), IsAligned(Aligned, 64));
+	TestEqual(TEXT("Counts the bytes handed out"), static_cast<int64>(Arena.GetBytesUsed()), static_cast<int64>(25));
+
+	// Only the latest allocation can grow where it is
+	uint8* Last = static_cast<uint8*>(Arena.Allocate(16, 8));
+	TestTrue(TEXT("Latest allocation grows in place"), Arena.TryGrowInPlace(Last, 16, 32));
+	TestFalse(TEXT("Earlier allocation doesn't"), Arena.TryGrowInPlace(Aligned, 24, 48));
+	TestFalse(TEXT("Growth past the block doesn't"), Arena.TryGrowInPlace(Last, 32, 1 << 20));
+
+	// Bigger than a block, gets a block of its own and stays usable
+	uint8* Large = static_cast<uint8*>(Arena.Allocate(4096, 16));
+	FMemory::Memset(Large, 0xAB, 4096);
+	TestTrue(TEXT("Large allocation is writable end to end"), Large[0] == 0xAB && Large[4095] == 0xAB);
+
+	FStdbMessageArena& Child = Arena.CreateChild();
+	const SIZE_T Before = Arena.GetBytesUsed();
+	Child.Allocate(100, 4);
+	TestEqual(TEXT("Children count towards their parent"), static_cast<int64>(Arena.GetBytesUsed() - Before), static_cast<int64>(100));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbArenaArrayTest, "SpacetimeDB.Arena.ArenaArray", STDB_TEST_FLAGS)
+
+bool FStdbArenaArrayTest::RunTest(const FString& Parameters)
+{
+	TestNull(TEXT("No arena outside a scope"), FStdbMessageArena::GetCurrent());
+
+	FStdbMessageArena Arena;
+	TStdbArenaArray<uint64> OnHeap;
+	{
+		FStdbArenaScope Scope(&Arena);
+		TestTrue(TEXT("Scope makes the arena current"), FStdbMessageArena::GetCurrent() == &Arena);
+
+		TStdbArenaArray<uint64> InArena;
+		for (uint64 i = 0; i < 1000; ++i)
+		{
+			InArena.Add(i * 3);
+		}
+		TestTrue(TEXT("Array memory comes from the arena"), Arena.GetBytesUsed() >= 1000 * sizeof(uint64));
+
+		{
+			FStdbMessageArena Inner;
+			FStdbArenaScope InnerScope(&Inner);
+			TestTrue(TEXT("Scopes nest"), FStdbMessageArena::GetCurrent() == &Inner);
+		}
+		TestTrue(TEXT("Inner scope restores the outer arena"), FStdbMessageArena::GetCurrent() == &Arena);
+
+		// The moved to array takes the arena memory along with the elements
+		OnHeap = MoveTemp(InArena);
+	}
+	TestNull(TEXT("Scope end restores no arena"), FStdbMessageArena::GetCurrent());
+
+	bool bAllKept = OnHeap.Num() == 1000;
+	for (int32 i = 0; bAllKept && i < OnHeap.Num(); ++i)
+	{
+		bAllKept = OnHeap[i] == static_cast<uint64>(i) * 3;
+	}
+	TestTrue(TEXT("Elements survive growth and the move"), bAllKept);
+
+	// Without a current arena the array is a plain heap array
+	const SIZE_T ArenaBytes = Arena.GetBytesUsed();
+	TStdbArenaArray<uint32> Heap;
+	Heap.Init(7, 512);
+	TestEqual(TEXT("Heap array doesn't touch the arena"), static_cast<int64>(Arena.GetBytesUsed()), static_cast<int64>(ArenaBytes));
+	Heap.Empty();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbArenaArrayBenchmark, "SpacetimeDB.Benchmark.ArenaArrays", STDB_BENCHMARK_FLAGS)
+
+bool FStdbArenaArrayBenchmark::RunTest(const FString& Parameters)
+{
+	// What a message with many table updates does: lots of small arrays that all die together
+	const int32 NumArrays = 20000;
+	const int32 NumElements = 16;
+
+	const double HeapSeconds = StdbBenchmark::TimeBest(5, [&]
+	{
+		TArray<TArray<uint64>> Arrays;
+		Arrays.Reserve(NumArrays);
+		for (int32 i = 0; i < NumArrays; ++i)
+		{
+			TArray<uint64>& Array = Arrays.AddDefaulted_GetRef();
+			for (int32 j = 0; j < NumElements; ++j)
+			{
+				Array.Add(j);
+			}
+		}
+	});
+
+	const double ArenaSeconds = StdbBenchmark::TimeBest(5, [&]
+	{
+		FStdbMessageArena Arena;
+		FStdbArenaScope Scope(&Arena);
+		TArray<TStdbArenaArray<uint64>> Arrays;
+		Arrays.Reserve(NumArrays);
+		for (int32 i = 0; i < NumArrays; ++i)
+		{
+			TStdbArenaArray<uint64>& Array = Arrays.AddDefaulted_GetRef();
+			for (int32 j = 0; j < NumElements; ++j)
+			{
+				Array.Add(j);
+			}
+		}
+	});
+
+	StdbBenchmark::Report(*this, TEXT("20k arrays of 16 u64, built and freed"), TEXT("heap"), HeapSeconds, TEXT("arena"), ArenaSeconds);
+	return true;
+}
+
+#endif
@@ -0,0 +1,74 @@
+#include "Misc/AutomationTest.h"
+#include "FStdbSender.h"
+#include "HAL/PlatformProcess.h"
+#include "Tests/StdbBenchmark.h"
+#include <atomic>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbSenderBackpressureTest, "SpacetimeDB.Sender.Backpressure", STDB_TEST_FLAGS)
+
+bool FStdbSenderBackpressureTest::RunTest(const FString& Parameters)
+{
+	const int32 QueueCapacity = 4;
+	std::atomic<bool> bConnected{false};
+	FCriticalSection SentLock;
+	TArray<uint8> Sent;
+	FStdbSender Sender([&bConnected, &SentLock, &Sent](const TArray<uint8>& Frame)
+	{
+		if (!bConnected.load())
+		{
+			return false;
+		}
+		FScopeLock Lock(&SentLock);
+		Sent.Add(Frame[0]);
+		return true;
+	}, QueueCapacity);
+	Sender.Start(TEXT("StdbSenderTest"));
+
+	// The connection is down: the batch and the queue fill up, then frames are refused
+	int32 NumAccepted = 0;
+	int32 NumRefused = 0;
+	for (int32 i = 0; i < 64 && NumRefused < 8; ++i)
+	{
+		FStdbSharedBuffer Frame = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+		Frame->Add(static_cast<uint8>(NumAccepted));
+		if (Sender.TryEnqueue(Frame))
+		{
+			++NumAccepted;
+		}
+		else
+		{
+			++NumRefused;
+		}
+		FPlatformProcess::Sleep(0.005f);
+	}
+	TestTrue(TEXT("Frames are refused while the connection is down"), NumRefused > 0);
+	TestTrue(TEXT("The batch takes at most one queue of frames"), NumAccepted >= QueueCapacity && NumAccepted <= 2 * QueueCapacity);
+
+	// Everything taken goes out in order once the connection is back, the queued frames after the batch
+	bConnected = true;
+	Sender.Wake();
+	for (int32 Wait = 0; Wait < 500; ++Wait)
+	{
+		{
+			FScopeLock Lock(&SentLock);
+			if (Sent.Num() >= NumAccepted)
+			{
+				break;
+			}
+		}
+		FPlatformProcess::Sleep(0.01f);
+	}
+	Sender.Shutdown();
+
+	bool bInOrder = Sent.Num() == NumAccepted;
+	for (int32 i = 0; bInOrder && i < Sent.Num(); ++i)
+	{
+		bInOrder = Sent[i] == i;
+	}
+	TestTrue(TEXT("Every accepted frame is sent in order"), bInOrder);
+	return true;
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include "Misc/AutomationTest.h"
+#include "ClientCache/TStdbRowStorage.h"
+#include "ClientCache/TStdbSparseSetStorage.h"
+#include "Tests/StdbBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// Shaped like food: an #[auto_inc] id and a little payload
+	struct FChurnRow
+	{
+		using FPrimaryKey = uint32;
+
+		uint32 EntityId = 0;
+		uint32 Payload = 0;
+
+		FPrimaryKey GetPrimaryKey() const { return EntityId; }
+	};
+
+	/** Food eaten and respawned: the oldest id leaves, a fresh one comes in, and a few live rows are looked up */
+	template<typename TStorage>
+	uint64 RunChurn(TStorage& Storage, int32 Population, int32 Steps)
+	{
+		Storage.Reset();
+		for (int32 i = 0; i < Population; ++i)
+		{
+			Storage.AddOrReplace(FChurnRow{static_cast<uint32>(i + 1), static_cast<uint32>(i)});
+		}
+
+		uint64 Checksum = 0;
+		uint32 Oldest = 1;
+		uint32 NextId = Population + 1;
+		for (int32 Step = 0; Step < Steps; ++Step)
+		{
+			Storage.Remove(Oldest++);
+			Storage.AddOrReplace(FChurnRow{NextId, static_cast<uint32>(Step)});
+			++NextId;
+
+			const uint32 Probe = Oldest + static_cast<uint32>(Step) % static_cast<uint32>(Population);
+			if (const FChurnRow* Row = Storage.Find(Probe))
+			{
+				Checksum += Row->Payload;
+			}
+		}
+		return Checksum + Storage.Num();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbSparseSetStorageTest, "SpacetimeDB.Cache.SparseSetStorage", STDB_TEST_FLAGS)
+
+bool FStdbSparseSetStorageTest::RunTest(const FString& Parameters)
+{
+	TStdbSparseSetStorage<FChurnRow> Storage;
+	TMap<uint32, uint32> Model;
+
+	// Keys spread over several pages, removals swap the last row into the hole
+	FRandomStream Random(1234);
+	for (int32 Op = 0; Op < 20000; ++Op)
+	{
+		const uint32 Key = static_cast<uint32>(Random.RandRange(0, static_cast<int32>(4 * FStdbSparseIndex::PageSize)));
+		if (Random.FRand() < 0.6f)
+		{
+			const bool bReplaced = Storage.AddOrReplace(FChurnRow{Key, static_cast<uint32>(Op)});
+			if (!TestTrue(TEXT("AddOrReplace reports a stored key"), bReplaced == Model.Contains(Key)))
+			{
+				return false;
+			}
+			Model.Add(Key, static_cast<uint32>(Op));
+		}
+		else if (!TestTrue(TEXT("Remove reports a stored key"), Storage.Remove(Key) == (Model.Remove(Key) > 0)))
+		{
+			return false;
+		}
+	}
+
+	TestEqual(TEXT("Row count matches"), Storage.Num(), Model.Num());
+	bool bAllFound = true;
+	for (const TPair<uint32, uint32>& Pair : Model)
+	{
+		const FChurnRow* Row = Storage.Find(Pair.Key);
+		bAllFound &= Row && Row->Payload == Pair.Value;
+	}
+	TestTrue(TEXT("Every stored key finds its latest row"), bAllFound);
+
+	// A page emptied and refilled maps keys again
+	for (const TPair<uint32, uint32>& Pair : Model)
+	{
+		Storage.Remove(Pair.Key);
+	}
+	TestEqual(TEXT("Emptied"), Storage.Num(), 0);
+	TestFalse(TEXT("Removed keys are gone"), Storage.Contains(FStdbSparseIndex::PageSize + 1));
+	TestFalse(TEXT("Adding into a freed page is an insert"), Storage.AddOrReplace(FChurnRow{FStdbSparseIndex::PageSize + 1, 5}));
+	TestTrue(TEXT("Refilled page finds its key"), Storage.Find(FStdbSparseIndex::PageSize + 1) != nullptr);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbSparseSetChurnBenchmark, "SpacetimeDB.Benchmark.SparseSetChurn", STDB_BENCHMARK_FLAGS)
+
+bool FStdbSparseSetChurnBenchmark::RunTest(const FString& Parameters)
+{
+	const int32 Population = 5000;
+	const int32 Steps = 1000000;
+
+	TStdbRowStorage<FChurnRow> MapStorage;
+	uint64 MapChecksum = 0;
+	const double MapSeconds = StdbBenchmark::TimeBest(3, [&]
+	{
+		MapChecksum = RunChurn(MapStorage, Population, Steps);
+	});
+
+	TStdbSparseSetStorage<FChurnRow> SparseStorage;
+	uint64 SparseChecksum = 0;
+	const double SparseSeconds = StdbBenchmark::TimeBest(3, [&]
+	{
+		SparseChecksum = RunChurn(SparseStorage, Population, Steps);
+	});
+
+	TestTrue(TEXT("Both storages end up with the same rows"), SparseChecksum == MapChecksum);
+	StdbBenchmark::Report(*this, TEXT("1M remove, insert and find steps over 5000 rows"), TEXT("TMap"), MapSeconds,
+	                      TEXT("sparse set"), SparseSeconds);
+	return true;
+}
+
+#endif
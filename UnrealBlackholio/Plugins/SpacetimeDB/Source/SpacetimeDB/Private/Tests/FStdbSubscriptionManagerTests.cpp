@@ -0,0 +1,98 @@
+#include "Misc/AutomationTest.h"
+#include "FStdbSubscriptionManager.h"
+#include "Tests/StdbBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbSubscriptionLifecycleTest, "SpacetimeDB.Subscriptions.Lifecycle", STDB_TEST_FLAGS)
+
+bool FStdbSubscriptionLifecycleTest::RunTest(const FString& Parameters)
+{
+	int32 NumSubscribes = 0;
+	int32 NumUnsubscribes = 0;
+	FStdbSubscriptionManager Subscriptions([&NumSubscribes, &NumUnsubscribes](const FClientMessage& Message)
+	{
+		NumSubscribes += Message.Data.IsType<FSubscribeMultiData>() ? 1 : 0;
+		NumUnsubscribes += Message.Data.IsType<FUnsubscribeMultiData>() ? 1 : 0;
+		return true;
+	});
+
+	TArray<uint32> Applied;
+	TArray<uint32> Ended;
+	FStdbSubscriptionManager::FOnApplied OnApplied;
+	OnApplied.BindLambda([&Applied](FQueryId QueryId) { Applied.Add(QueryId.Id); });
+	FStdbSubscriptionManager::FOnEnded OnEnded;
+	OnEnded.BindLambda([&Ended](FQueryId QueryId) { Ended.Add(QueryId.Id); });
+
+	const FQueryId First = Subscriptions.Subscribe({TEXT("SELECT * FROM rows")}, OnApplied);
+	const FQueryId Second = Subscriptions.Subscribe({TEXT("SELECT * FROM other")}, OnApplied);
+	TestTrue(TEXT("Every set gets its own query id"), First.Id != 0 && Second.Id != 0 && First.Id != Second.Id);
+	TestEqual(TEXT("Every set sends a SubscribeMulti"), NumSubscribes, 2);
+	TestTrue(TEXT("Set is pending until applied"), Subscriptions.GetState(First) == EStdbSubscriptionState::Pending);
+
+	Subscriptions.HandleSubscribeMultiApplied(FSubscribeMultiAppliedData(1, 0, First, FDatabaseUpdate()));
+	TestTrue(TEXT("Applied set runs OnApplied"), Applied == TArray<uint32>{First.Id});
+	TestTrue(TEXT("Applied set is applied"), Subscriptions.GetState(First) == EStdbSubscriptionState::Applied);
+
+	// A pending set is unsubscribed once the server knows it
+	TestTrue(TEXT("Pending set can be unsubscribed"), Subscriptions.Unsubscribe(Second, OnEnded));
+	TestEqual(TEXT("Pending set isn't unsubscribed yet"), NumUnsubscribes, 0);
+	Subscriptions.HandleSubscribeMultiApplied(FSubscribeMultiAppliedData(2, 0, Second, FDatabaseUpdate()));
+	TestEqual(TEXT("Unsubscribe follows the apply"), NumUnsubscribes, 1);
+	TestTrue(TEXT("Unsubscribed set doesn't run OnApplied"), Applied == TArray<uint32>{First.Id});
+	Subscriptions.HandleUnsubscribeMultiApplied(FUnsubscribeMultiAppliedData(3, 0, Second, FDatabaseUpdate()));
+	TestTrue(TEXT("Ended set runs OnEnded"), Ended == TArray<uint32>{Second.Id});
+	TestTrue(TEXT("Ended set is forgotten"), Subscriptions.GetState(Second) == EStdbSubscriptionState::None);
+
+	TestTrue(TEXT("Applied set can be unsubscribed"), Subscriptions.Unsubscribe(First, OnEnded));
+	TestTrue(TEXT("Set is unsubscribing until the server answers"), Subscriptions.GetState(First) == EStdbSubscriptionState::Unsubscribing);
+	TestFalse(TEXT("Unsubscribing twice is refused"), Subscriptions.Unsubscribe(First, OnEnded));
+	Subscriptions.HandleUnsubscribeMultiApplied(FUnsubscribeMultiAppliedData(4, 0, First, FDatabaseUpdate()));
+	TestEqual(TEXT("No set is left"), Subscriptions.Num(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbSubscriptionResetTest, "SpacetimeDB.Subscriptions.Reset", STDB_TEST_FLAGS)
+
+bool FStdbSubscriptionResetTest::RunTest(const FString& Parameters)
+{
+	TArray<uint32> SentRequestIds;
+	FStdbSubscriptionManager Subscriptions([&SentRequestIds](const FClientMessage& Message)
+	{
+		if (Message.Data.IsType<FSubscribeMultiData>())
+		{
+			SentRequestIds.Add(Message.Data.Get<FSubscribeMultiData>().RequestId);
+		}
+		return true;
+	});
+
+	int32 NumErrors = 0;
+	FStdbSubscriptionManager::FOnError OnError;
+	OnError.BindLambda([&NumErrors](FQueryId, const FString&) { ++NumErrors; });
+
+	const FQueryId First = Subscriptions.Subscribe({TEXT("SELECT * FROM rows")}, FStdbSubscriptionManager::FOnApplied(), OnError);
+	TestTrue(TEXT("Subscribe is pending"), Subscriptions.GetState(First) == EStdbSubscriptionState::Pending);
+
+	// The connection went away: every set is forgotten without callbacks
+	Subscriptions.Reset();
+	TestEqual(TEXT("Reset forgets every set"), Subscriptions.Num(), 0);
+	TestTrue(TEXT("Reset set has no state"), Subscriptions.GetState(First) == EStdbSubscriptionState::None);
+
+	// Ids sent outside the manager and after the reset never reuse one still in flight
+	const uint32 Outside = Subscriptions.AllocateRequestId();
+	const FQueryId Second = Subscriptions.Subscribe({TEXT("SELECT * FROM rows")}, FStdbSubscriptionManager::FOnApplied(), OnError);
+	TestTrue(TEXT("Request ids keep counting across Reset"),
+		SentRequestIds.Num() == 2 && Outside != SentRequestIds[0] && SentRequestIds[1] != SentRequestIds[0] && SentRequestIds[1] != Outside);
+
+	// An error for the old connection's request can't fail the new set
+	Subscriptions.HandleSubscriptionError(FSubscriptionErrorData(0, SentRequestIds[0], TOptional<uint32>(), TOptional<uint32>(), TEXT("stale")));
+	TestEqual(TEXT("Stale error is ignored"), NumErrors, 0);
+	TestTrue(TEXT("New set is still pending"), Subscriptions.GetState(Second) == EStdbSubscriptionState::Pending);
+
+	Subscriptions.HandleSubscriptionError(FSubscriptionErrorData(0, SentRequestIds[1], TOptional<uint32>(), TOptional<uint32>(), TEXT("bad query")));
+	TestEqual(TEXT("Error for the new request fails its set"), NumErrors, 1);
+	TestTrue(TEXT("Failed set keeps the error"), Subscriptions.GetState(Second) == EStdbSubscriptionState::Error);
+	return true;
+}
+
+#endif
@@ -0,0 +1,285 @@
+#include "Misc/AutomationTest.h"
+#include "TStdbBsatn.h"
+#include "ClientCache/TStdbTableCache.h"
+#include "Tests/StdbBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	struct FCacheRow
+	{
+		using FPrimaryKey = uint32;
+
+		uint32 Id = 0;
+		uint32 Value = 0;
+
+		FPrimaryKey GetPrimaryKey() const { return Id; }
+
+		STDB_BSATN_FIELDS(Id, Value)
+	};
+
+	using FCacheTable = TStdbTableCache<FCacheRow>;
+	using FCacheDiff = TStdbTableDiff<FCacheRow>;
+
+	/** Callbacks a diff fired, in the order the cache runs them */
+	struct FCallbackLog
+	{
+		TArray<uint32> Deleted;
+		TArray<uint32> Updated;
+		TArray<uint32> Inserted;
+
+		void Bind(FCacheTable& Table)
+		{
+			Table.OnDelete.AddLambda([this](const FCacheRow& Row) { Deleted.Add(Row.Id); });
+			Table.OnUpdate.AddLambda([this](const FCacheRow& OldRow, const FCacheRow& NewRow) { Updated.Add(NewRow.Id); });
+			Table.OnInsert.AddLambda([this](const FCacheRow& Row) { Inserted.Add(Row.Id); });
+		}
+
+		void Reset()
+		{
+			Deleted.Reset();
+			Updated.Reset();
+			Inserted.Reset();
+		}
+	};
+
+	/** One message for the table, run through the same steps the client takes */
+	TUniquePtr<IStdbTableDiff> Apply(FCacheTable& Table, TArray<FCacheRow> Deletes, TArray<FCacheRow> Inserts)
+	{
+		TUniquePtr<FCacheDiff> Diff = MakeUnique<FCacheDiff>();
+		Diff->Deletes = MoveTemp(Deletes);
+		Diff->Inserts = MoveTemp(Inserts);
+		Table.FinishDiff(*Diff);
+		Table.CommitDiff(*Diff);
+		Table.BroadcastDiff(*Diff);
+		return Diff;
+	}
+
+	bool HasRow(const FCacheTable& Table, uint32 Id, uint32 Value)
+	{
+		const FCacheRow* Row = Table.Find(Id);
+		return Row && Row->Value == Value;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbTableDiffMatchTest, "SpacetimeDB.Cache.DiffMatchUpdates", STDB_TEST_FLAGS)
+
+bool FStdbTableDiffMatchTest::RunTest(const FString& Parameters)
+{
+	FCacheDiff Diff;
+	Diff.Deletes = {{1, 10}, {2, 20}, {3, 30}};
+	Diff.Inserts = {{2, 21}, {4, 40}, {3, 31}};
+	Diff.MatchUpdates();
+
+	TestEqual(TEXT("Matched pairs become updates"), Diff.Updates.Num(), 2);
+	TestTrue(TEXT("Update keeps the old and the new row"),
+		Diff.Updates.Num() == 2 && Diff.Updates[0].OldRow.Value == 20 && Diff.Updates[0].NewRow.Value == 21);
+	TestTrue(TEXT("Unmatched delete stays a delete"), Diff.Deletes.Num() == 1 && Diff.Deletes[0].Id == 1);
+	TestTrue(TEXT("Unmatched insert stays an insert"), Diff.Inserts.Num() == 1 && Diff.Inserts[0].Id == 4);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbTableCacheCommitTest, "SpacetimeDB.Cache.TableCommit", STDB_TEST_FLAGS)
+
+bool FStdbTableCacheCommitTest::RunTest(const FString& Parameters)
+{
+	FCacheTable Table(TEXT("rows"));
+	TStdbUniqueIndex<FCacheRow, uint32>& ByValue = Table.AddUniqueIndex(TEXT("value"), &FCacheRow::Value);
+	FCallbackLog Log;
+	Log.Bind(Table);
+
+	Apply(Table, {}, {{1, 10}, {2, 20}, {3, 30}});
+	TestEqual(TEXT("Inserts are stored"), Table.Num(), 3);
+	TestEqual(TEXT("Every insert is reported"), Log.Inserted.Num(), 3);
+
+	// The server sends a changed row as a delete and an insert of the same key
+	Log.Reset();
+	Apply(Table, {{2, 20}}, {{2, 22}});
+	TestTrue(TEXT("Changed row replaces the stored one"), HasRow(Table, 2, 22));
+	TestTrue(TEXT("Changed row fires OnUpdate only"),
+		Log.Updated == TArray<uint32>{2} && Log.Deleted.Num() == 0 && Log.Inserted.Num() == 0);
+	TestTrue(TEXT("Index follows the changed column"), ByValue.Find(20) == nullptr && ByValue.Find(22) && *ByValue.Find(22) == 2);
+
+	// A delete and insert of a key the cache never had is a row entering it
+	Log.Reset();
+	Apply(Table, {{9, 90}}, {{9, 91}});
+	TestTrue(TEXT("Unstored update is stored"), HasRow(Table, 9, 91));
+	TestTrue(TEXT("Unstored update is reported as an insert"), Log.Inserted == TArray<uint32>{9} && Log.Updated.Num() == 0);
+	TestTrue(TEXT("Unstored update is indexed"), ByValue.Find(91) != nullptr);
+
+	Log.Reset();
+	Apply(Table, {{1, 10}, {5, 50}}, {});
+	TestFalse(TEXT("Delete removes the row"), Table.Contains(1));
+	TestTrue(TEXT("Only rows that were stored are reported deleted"), Log.Deleted == TArray<uint32>{1});
+	TestTrue(TEXT("Delete leaves the index"), ByValue.Find(10) == nullptr);
+
+	Table.Clear();
+	TestEqual(TEXT("Clear drops every row"), Table.Num(), 0);
+	TestEqual(TEXT("Clear drops every index entry"), ByValue.Num(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbBTreeIndexTest, "SpacetimeDB.Cache.BTreeIndex", STDB_TEST_FLAGS)
+
+bool FStdbBTreeIndexTest::RunTest(const FString& Parameters)
+{
+	FCacheTable Table(TEXT("rows"));
+	const TStdbBTreeIndex<FCacheRow, uint32>& ByValue = Table.AddBTreeIndex(TEXT("value"), &FCacheRow::Value);
+
+	Apply(Table, {}, {{1, 30}, {2, 10}, {3, 30}, {4, 20}});
+	TestEqual(TEXT("One bucket per distinct value"), ByValue.NumKeys(), 3);
+	TestTrue(TEXT("Find returns every row of a value"), ByValue.Find(30).Num() == 2 && ByValue.Find(30).Contains(1) && ByValue.Find(30).Contains(3));
+	TestEqual(TEXT("Missing value finds nothing"), ByValue.Find(15).Num(), 0);
+
+	TArray<uint32> InRange;
+	ByValue.ForEachInRange(15, 30, [&InRange](uint32 Value, uint32 Id) { InRange.Add(Value); });
+	TestTrue(TEXT("Range scan walks values in order"), InRange == TArray<uint32>({20, 30, 30}));
+
+	// Moving a row to another value and dropping the last row of a value
+	Apply(Table, {{1, 30}, {4, 20}}, {{1, 5}});
+	TestTrue(TEXT("Updated row moves bucket"), ByValue.Find(5).Num() == 1 && ByValue.Find(30).Num() == 1);
+	TestEqual(TEXT("Emptied bucket is dropped"), ByValue.Find(20).Num(), 0);
+	TestEqual(TEXT("Buckets follow the distinct values"), ByValue.NumKeys(), 3);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbBTreeIndexBenchmark, "SpacetimeDB.Benchmark.BTreeIndex", STDB_BENCHMARK_FLAGS)
+
+bool FStdbBTreeIndexBenchmark::RunTest(const FString& Parameters)
+{
+	// 16 circles for each of 1024 players, the shape of circle.player_id
+	const int32 NumValues = 1024;
+	const int32 RowsPerValue = 16;
+	FCacheTable Table(TEXT("rows"));
+	TStdbBTreeIndex<FCacheRow, uint32>& ByValue = Table.AddBTreeIndex(TEXT("value"), &FCacheRow::Value);
+	TArray<FCacheRow> Rows;
+	for (int32 i = 0; i < NumValues * RowsPerValue; ++i)
+	{
+		Rows.Add({static_cast<uint32>(i), static_cast<uint32>(i % NumValues + 1)});
+	}
+	Apply(Table, {}, Rows);
+
+	// Lookups of every value: the scan over the table the index replaces, then the index
+	int64 ScanMatches = 0;
+	const double ScanSeconds = StdbBenchmark::TimeBest(5, [&]
+	{
+		ScanMatches = 0;
+		for (uint32 Value = 1; Value <= NumValues; ++Value)
+		{
+			for (const FCacheRow& Row : Table)
+			{
+				ScanMatches += Row.Value == Value ? 1 : 0;
+			}
+		}
+	});
+	int64 IndexMatches = 0;
+	const double IndexSeconds = StdbBenchmark::TimeBest(5, [&]
+	{
+		IndexMatches = 0;
+		for (uint32 Value = 1; Value <= NumValues; ++Value)
+		{
+			IndexMatches += ByValue.Find(Value).Num();
+		}
+	});
+	TestEqual(TEXT("Both lookups find every row"), ScanMatches, IndexMatches);
+	StdbBenchmark::Report(*this, TEXT("Find the rows of 1024 values in 16k rows"), TEXT("table scan"), ScanSeconds, TEXT("btree index"), IndexSeconds);
+
+	// Worst case upkeep: a value that comes and goes in front of all others, shifting every bucket twice
+	const int32 NumChurn = 4096;
+	const double ChurnSeconds = StdbBenchmark::TimeBest(5, [&]
+	{
+		for (int32 i = 0; i < NumChurn; ++i)
+		{
+			const FCacheRow Front{static_cast<uint32>(1000000 + i), 0};
+			ByValue.OnInsert(Front);
+			ByValue.OnDelete(Front);
+		}
+	});
+	TestEqual(TEXT("Churn leaves the buckets as they were"), ByValue.NumKeys(), NumValues);
+	AddInfo(FString::Printf(TEXT("Add and drop a value in front of %d buckets: %.3f us per row"), NumValues, ChurnSeconds * 1e6 / NumChurn));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbTableCacheRefCountTest, "SpacetimeDB.Cache.OverlappingSubscriptions", STDB_TEST_FLAGS)
+
+bool FStdbTableCacheRefCountTest::RunTest(const FString& Parameters)
+{
+	FCacheTable Table(TEXT("rows"));
+	FCallbackLog Log;
+	Log.Bind(Table);
+
+	// Three subscriptions match the same row, each sends it
+	Apply(Table, {}, {{1, 10}});
+	Apply(Table, {}, {{1, 10}, {2, 20}});
+	TUniquePtr<IStdbTableDiff> Third = Apply(Table, {}, {{1, 10}});
+	TestTrue(TEXT("A shared row is reported once"), Log.Inserted == TArray<uint32>({1, 2}));
+	TestEqual(TEXT("A shared row leaves the committed diff"), static_cast<FCacheDiff&>(*Third).Inserts.Num(), 0);
+	TestEqual(TEXT("A shared row is stored once"), Table.Num(), 2);
+
+	Log.Reset();
+	Apply(Table, {{1, 10}}, {});
+	Apply(Table, {{1, 10}}, {});
+	TestTrue(TEXT("Row stays while a subscription holds it"), Table.Contains(1) && Log.Deleted.Num() == 0);
+
+	Apply(Table, {{1, 10}}, {});
+	TestTrue(TEXT("Row goes with the last subscription"), !Table.Contains(1) && Log.Deleted == TArray<uint32>{1});
+
+	// Clear forgets the references, a fresh insert and delete of the row aren't held back
+	Apply(Table, {}, {{2, 20}});
+	Table.Clear();
+	Log.Reset();
+	Apply(Table, {}, {{2, 20}});
+	Apply(Table, {{2, 20}}, {});
+	TestTrue(TEXT("References don't outlive Clear"), !Table.Contains(2) && Log.Deleted == TArray<uint32>{2});
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStdbTableSnapshotTest, "SpacetimeDB.Cache.TableSnapshots", STDB_TEST_FLAGS)
+
+bool FStdbTableSnapshotTest::RunTest(const FString& Parameters)
+{
+	using FSnapshot = FCacheTable::FSnapshot;
+
+	FCacheTable Table(TEXT("rows"));
+	Table.EnableSnapshots();
+
+	Apply(Table, {}, {{1, 10}});
+	FStdbTableSnapshotPtr Seeded = Table.SeedSnapshot(1);
+	const IStdbTableSnapshot* SeededBuffer = Seeded.Get();
+
+	FStdbTableSnapshotPtr Second = Table.BuildSnapshot(2, Apply(Table, {}, {{2, 20}}));
+	const FSnapshot& SecondRows = static_cast<const FSnapshot&>(*Second);
+	TestTrue(TEXT("Built snapshot has the new row"), SecondRows.Num() == 2 && SecondRows.Find(2));
+	TestTrue(TEXT("Held snapshot doesn't change"), static_cast<const FSnapshot&>(*Seeded).Num() == 1 && Seeded->GetVersion() == 1);
+
+	// Once the reader lets go the buffer is caught up with both diffs instead of copied
+	Seeded.Reset();
+	FStdbTableSnapshotPtr Third = Table.BuildSnapshot(3, Apply(Table, {{1, 10}, {2, 20}}, {{2, 21}}));
+	const FSnapshot& ThirdRows = static_cast<const FSnapshot&>(*Third);
+	TestTrue(TEXT("Released buffer is reused"), Third.Get() == SeededBuffer);
+	TestTrue(TEXT("Reused buffer matches the table"),
+		ThirdRows.Num() == 1 && !ThirdRows.Find(1) && ThirdRows.Find(2) && ThirdRows.Find(2)->Value == 21 && Third->GetVersion() == 3);
+	TestTrue(TEXT("Published snapshot isn't patched under its reader"), SecondRows.Num() == 2 && SecondRows.Find(2)->Value == 20);
+
+	// Second is still held, so the next one is a fresh copy
+	FStdbTableSnapshotPtr Fourth = Table.BuildSnapshot(4, Apply(Table, {}, {{3, 30}}));
+	TestTrue(TEXT("Held buffer is copied instead"), Fourth.Get() != Second.Get());
+	TestEqual(TEXT("Copied buffer matches the table"), static_cast<const FSnapshot&>(*Fourth).Num(), Table.Num());
+
+	Table.Clear();
+	FStdbTableSnapshotPtr Cleared = Table.BuildSnapshot(5, nullptr);
+	TestEqual(TEXT("Cleared table publishes an empty snapshot"), static_cast<const FSnapshot&>(*Cleared).Num(), 0);
+
+	// Enabled after a reconnect cleared it, once the cache was seeded without it
+	FCacheTable Late(TEXT("late"));
+	Apply(Late, {}, {{1, 10}});
+	Late.Clear();
+	Late.EnableSnapshots();
+	FStdbTableSnapshotPtr LateFirst = Late.BuildSnapshot(6, Apply(Late, {}, {{2, 20}}));
+	TestTrue(TEXT("Unseeded table builds from an empty snapshot"),
+		static_cast<const FSnapshot&>(*LateFirst).Num() == 1 && static_cast<const FSnapshot&>(*LateFirst).Find(2));
+	return true;
+}
+
+#endif
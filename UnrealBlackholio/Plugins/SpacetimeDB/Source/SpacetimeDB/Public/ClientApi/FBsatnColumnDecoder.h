@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <type_traits>
+#include "ClientApi/FServerMessage.h"
+
+/** One field of a fixed-size row: where it sits in the row and the column it goes to */
+struct FBsatnColumn
+{
+	int32 Offset;
+	int32 Size;
+	uint8* Dest;
+	// Bytes from one value to the next in Dest, 0 packs them densely
+	int32 Stride = 0;
+};
+
+/**
+ * FBsatnColumnDecoder: Scatters the fields of FixedSize row lists into typed column arrays or
+ * straight into row structs, for tables whose rows are plain fixed-width fields like entity and food.
+ * 16 byte rows made of 4 and 8 byte fields going to dense columns are transposed four rows at a time
+ * with SSE2 or NEON, everything else, and the last rows of a list, go through a scalar copy per field.
+ */
+class SPACETIMEDB_API FBsatnColumnDecoder
+{
+public:
+	/**
+	 * Decodes every row of Rows into Columns, each Dest needs room for Rows.Num() values.
+	 * Returns false without writing anything if Rows isn't FixedSize, a column doesn't fit in a row
+	 * or its Stride is smaller than a value.
+	 */
+	static bool DecodeFixedRows(const FBsatnRowList& Rows, TArrayView<const FBsatnColumn> Columns);
+
+	/**
+	 * Grows Out by NumRows uninitialized values and returns the column writing them.
+	 * T is the in-memory type of a field encoded as sizeof(T) raw little-endian bytes.
+	 */
+	template<typename T>
+	static FBsatnColumn AppendColumn(int32 Offset, TArray<T>& Out, int32 NumRows)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Columns are filled with raw copies of the row bytes");
+		const int32 Start = Out.AddUninitialized(NumRows);
+		return FBsatnColumn{Offset, static_cast<int32>(sizeof(T)), reinterpret_cast<uint8*>(Out.GetData() + Start)};
+	}
+
+	/**
+	 * Returns the column writing Field of consecutive rows starting at FirstRow, which need to exist already.
+	 * T is the in-memory type of a field encoded as sizeof(T) raw little-endian bytes.
+	 */
+	template<typename TRow, typename T>
+	static FBsatnColumn FieldColumn(int32 Offset, TRow* FirstRow, T TRow::* Field)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Columns are filled with raw copies of the row bytes");
+		return FBsatnColumn{Offset, static_cast<int32>(sizeof(T)), reinterpret_cast<uint8*>(&(FirstRow->*Field)), static_cast<int32>(sizeof(TRow))};
+	}
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FBinaryReader.h"
+
+/**
+ * Buffer that owns the decoded bytes of a server message. Row views and byte views inside
+ * an FServerMessage point into this buffer, so it is shared by everything decoded from it.
+ */
+using FStdbSharedBuffer = TSharedPtr<TArray<uint8>, ESPMode::ThreadSafe>;
+
+/**
+ * FBsatnRowView: Non-owning view of a single BSATN encoded row.
+ * Only valid while the buffer it was sliced from is alive.
+ */
+struct SPACETIMEDB_API FBsatnRowView
+{
+	const uint8* Data;
+	int32 Size;
+
+	FBsatnRowView()
+		: Data(nullptr)
+		, Size(0)
+	{
+	}
+
+	FBsatnRowView(const uint8* InData, int32 InSize)
+		: Data(InData)
+		, Size(InSize)
+	{
+	}
+
+	FBinaryReader GetReader() const
+	{
+		return FBinaryReader(Data, Size);
+	}
+
+	TArrayView<const uint8> GetBytes() const
+	{
+		return TArrayView<const uint8>(Data, Size);
+	}
+
+	/** Decodes the row into a struct exposing ReadFields(FBinaryReader&) */
+	template<typename TRow>
+	TRow Decode() const
+	{
+		TRow Row;
+		FBinaryReader Reader = GetReader();
+		Row.ReadFields(Reader);
+		return Row;
+	}
+};
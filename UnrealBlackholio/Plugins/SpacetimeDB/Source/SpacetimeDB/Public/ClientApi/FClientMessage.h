@@ -3,7 +3,9 @@
 #include "CoreMinimal.h"
 #include "FBinaryReader.h"
 #include "FBinaryWriter.h"
+#include "FBinarySpanWriter.h"
 #include "FQueryId.h"
+#include "TStdbBsatn.h"
 #include "LogStdb.h"
 
 UENUM()
@@ -18,6 +20,15 @@ enum class EClientMessageType : uint8
 	UnsubscribeMulti
 };
 
+/** Values match the wire flags of CallReducer */
+enum class ECallReducerFlags : uint8
+{
+	// The caller receives a full TransactionUpdate for the call
+	FullUpdate = 0,
+	// The caller is only notified when the call fails
+	NoSuccessNotify = 1
+};
+
 struct SPACETIMEDB_API FCallReducerData
 {
 	FString Reducer;
@@ -40,21 +51,15 @@ struct SPACETIMEDB_API FCallReducerData
 	{
 	}
 
-	void ReadFields(FBinaryReader reader)
+	FCallReducerData(const FString& InReducer, TArray<uint8>&& InArgs, uint32 InRequestId, uint8 InFlags)
+		: Reducer(InReducer)
+		, Args(MoveTemp(InArgs))
+		, RequestId(InRequestId)
+		, Flags(InFlags)
 	{
-		Reducer = reader.ReadString();
-		Args = reader.ReadArray<uint8>([](FBinaryReader& R) { return R.ReadByte(); });
-		RequestId = reader.ReadUInt32();
-		Flags = reader.ReadByte();
 	}
 
-	void WriteFields(FBinaryWriter writer) const
-	{
-		writer.WriteString(Reducer);
-		writer.WriteArray<uint8>(Args, [](FBinaryWriter& W, const uint8& V) { W.WriteByte(V); });
-		writer.WriteUInt32(RequestId);
-		writer.WriteByte(Flags);
-	}
+	STDB_BSATN_FIELDS(Reducer, Args, RequestId, Flags)
 };
 
 struct SPACETIMEDB_API FSubscribeData
@@ -62,17 +67,7 @@ struct SPACETIMEDB_API FSubscribeData
 	TArray<FString> QueryStrings;
 	uint32 RequestId;
 
-	void ReadFields(FBinaryReader& reader)
-	{
-		QueryStrings = reader.ReadStringArray();
-		RequestId = reader.ReadUInt32();
-	}
-
-	void WriteFields(FBinaryWriter& writer) const
-	{
-		writer.WriteStringArray(QueryStrings);		
-		writer.WriteUInt32(RequestId);
-	}
+	STDB_BSATN_FIELDS(QueryStrings, RequestId)
 };
 
 struct SPACETIMEDB_API FOneOffQueryData
@@ -91,17 +86,7 @@ struct SPACETIMEDB_API FOneOffQueryData
 	{
 	}
 
-	void ReadFields(FBinaryReader reader)
-	{
-		MessageId = reader.ReadArray<uint8>([](FBinaryReader& R) { return R.ReadByte(); });
-		QueryString = reader.ReadString();
-	}
-
-	void WriteFields(FBinaryWriter writer) const
-	{
-		writer.WriteArray<uint8>(MessageId, [](FBinaryWriter& W, const uint8& V) { W.WriteByte(V); });
-		writer.WriteString(QueryString);
-	}
+	STDB_BSATN_FIELDS(MessageId, QueryString)
 };
 
 struct SPACETIMEDB_API FSubscribeSingleData
@@ -124,19 +109,7 @@ struct SPACETIMEDB_API FSubscribeSingleData
 	{
 	}
 
-	void ReadFields(FBinaryReader reader)
-	{
-		Query = reader.ReadString();
-		RequestId = reader.ReadUInt32();
-		QueryId.ReadFields(reader);
-	}
-
-	void WriteFields(FBinaryWriter writer) const
-	{
-		writer.WriteString(Query);
-		writer.WriteUInt32(RequestId);
-		QueryId.WriteFields(writer);
-	}
+	STDB_BSATN_FIELDS(Query, RequestId, QueryId)
 };
 
 struct SPACETIMEDB_API FSubscribeMultiData
@@ -158,19 +131,7 @@ struct SPACETIMEDB_API FSubscribeMultiData
 	{
 	}
 
-	void ReadFields(FBinaryReader reader)
-	{
-		QueryStrings = reader.ReadArray<FString>([](FBinaryReader& R) { return R.ReadString(); });
-		RequestId = reader.ReadUInt32();
-		QueryId.ReadFields(reader);
-	}
-
-	void WriteFields(FBinaryWriter writer) const
-	{
-		writer.WriteArray<FString>(QueryStrings, [](FBinaryWriter& W, const FString& V) { W.WriteString(V); });
-		writer.WriteUInt32(RequestId);
-		QueryId.WriteFields(writer);
-	}
+	STDB_BSATN_FIELDS(QueryStrings, RequestId, QueryId)
 };
 
 struct SPACETIMEDB_API FUnsubscribeData
@@ -190,17 +151,7 @@ struct SPACETIMEDB_API FUnsubscribeData
 	{
 	}
 
-	void ReadFields(FBinaryReader reader)
-	{
-		RequestId = reader.ReadUInt32();
-		QueryId.ReadFields(reader);
-	}
-
-	void WriteFields(FBinaryWriter writer) const
-	{
-		writer.WriteUInt32(RequestId);
-		QueryId.WriteFields(writer);
-	}
+	STDB_BSATN_FIELDS(RequestId, QueryId)
 };
 
 struct SPACETIMEDB_API FUnsubscribeMultiData
@@ -220,17 +171,7 @@ struct SPACETIMEDB_API FUnsubscribeMultiData
 	{
 	}
 
-	void ReadFields(FBinaryReader reader)
-	{
-		RequestId = reader.ReadUInt32();
-		QueryId.ReadFields(reader);
-	}
-
-	void WriteFields(FBinaryWriter writer) const
-	{
-		writer.WriteUInt32(RequestId);
-		QueryId.WriteFields(writer);
-	}
+	STDB_BSATN_FIELDS(RequestId, QueryId)
 };
 
 struct SPACETIMEDB_API FClientMessage
@@ -309,57 +250,31 @@ struct SPACETIMEDB_API FClientMessage
 		return result;		
 	}
 
-	static void Serialize(FClientMessage msg, FBinaryWriter& writer)
+	/** Exact encoded size of msg, tag byte included */
+	static int64 GetEncodedSize(const FClientMessage& msg)
 	{
-		writer.WriteByte(static_cast<uint8>(msg.Type));
-		switch (msg.Type)
-		{
-		case EClientMessageType::Subscribe:
-			{
-				FSubscribeData Subscribe = msg.Data.Get<FSubscribeData>();
-				Subscribe.WriteFields(writer);
-				break;
-			}
-		case EClientMessageType::CallReducer:
-			{
-				const FCallReducerData& CallReducer = msg.Data.Get<FCallReducerData>();
-				CallReducer.WriteFields(writer);
-				break;
-			}
-		case EClientMessageType::OneOffQuery:
-			{
-				const FOneOffQueryData& OneOffQuery = msg.Data.Get<FOneOffQueryData>();
-				OneOffQuery.WriteFields(writer);
-				break;
-			}
-		case EClientMessageType::SubscribeSingle:
-			{
-				const FSubscribeSingleData& SubscribeSingle = msg.Data.Get<FSubscribeSingleData>();
-				SubscribeSingle.WriteFields(writer);
-				break;
-			}
-		case EClientMessageType::SubscribeMulti:
-			{
-				const FSubscribeMultiData& SubscribeMulti = msg.Data.Get<FSubscribeMultiData>();
-				SubscribeMulti.WriteFields(writer);
-				break;
-			}
-		case EClientMessageType::Unsubscribe:
-			{
-				const FUnsubscribeData& Unsubscribe = msg.Data.Get<FUnsubscribeData>();
-				Unsubscribe.WriteFields(writer);
-				break;
-			}
-		case EClientMessageType::UnsubscribeMulti:
-			{
-				const FUnsubscribeMultiData& UnsubscribeMulti = msg.Data.Get<FUnsubscribeMultiData>();
-				UnsubscribeMulti.WriteFields(writer);
-				break;
-			}
-		default:
-			UE_LOG(LogStdb, Warning, TEXT("Cannot serialize unknown client message type: %d"), static_cast<int32>(msg.Type));
-			break;
-		}
+		return 1 + Visit([](const auto& Payload) { return StdbBsatn::Size(Payload); }, msg.Data);
+	}
+
+	/**
+	 * Encodes msg in a single pass: the exact size is computed first, claimed from writer in one
+	 * go and filled without further capacity checks.
+	 */
+	static void Serialize(const FClientMessage& msg, FBinaryWriter& writer)
+	{
+		// Variant alternatives are declared in EClientMessageType order
+		check(msg.Data.GetIndex() == static_cast<SIZE_T>(msg.Type));
+		Visit([&msg, &writer](const auto& Payload) { Serialize(msg.Type, Payload, writer); }, msg.Data);
+	}
+
+	/** Same as above straight from the payload struct, without building an FClientMessage */
+	template<typename TData>
+	static void Serialize(EClientMessageType Type, const TData& Data, FBinaryWriter& writer)
+	{
+		FBinarySpanWriter Span(writer.WriteUninitialized(1 + StdbBsatn::Size(Data)));
+		Span.WriteByte(static_cast<uint8>(Type));
+		StdbBsatn::Write(Span, Data);
+		check(Span.IsFull());
 	}
 
 	static FClientMessage Subscribe(FSubscribeData& data)
@@ -377,6 +292,51 @@ struct SPACETIMEDB_API FClientMessage
 		return Message;
 	}
 
+	static FClientMessage CallReducer(FCallReducerData&& data)
+	{
+		FClientMessage Message;
+		Message.Type = EClientMessageType::CallReducer;
+		Message.Data.Emplace<FCallReducerData>(MoveTemp(data));
+		return Message;
+	}
+
+	/**
+	 * Encodes a CallReducer message without building an FCallReducerData, the arguments are
+	 * written by WriteArgs straight behind their length prefix.
+	 */
+	static void SerializeCallReducer(const FString& Reducer, TFunctionRef<void(FBinaryWriter&)> WriteArgs,
+	                                 uint32 RequestId, uint8 Flags, FBinaryWriter& writer)
+	{
+		writer.WriteByte(static_cast<uint8>(EClientMessageType::CallReducer));
+		writer.WriteString(Reducer);
+
+		const int64 ArgsLengthPosition = writer.GetPosition();
+		writer.WriteInt32(0);
+		WriteArgs(writer);
+		writer.PatchInt32(ArgsLengthPosition, static_cast<int32>(writer.GetPosition() - ArgsLengthPosition - sizeof(int32)));
+
+		writer.WriteUInt32(RequestId);
+		writer.WriteByte(Flags);
+	}
+
+	/** Encodes a CallReducer message at its exact size, Args declares its fields with STDB_BSATN_FIELDS */
+	template<typename TArgs>
+	static void SerializeCallReducerArgs(const FString& Reducer, const TArgs& Args, uint32 RequestId, uint8 Flags,
+	                                     FBinaryWriter& writer)
+	{
+		const int64 ArgsSize = StdbBsatn::Size(Args);
+		const int64 Size = 1 + StdbBsatn::Size(Reducer) + sizeof(int32) + ArgsSize + sizeof(uint32) + sizeof(uint8);
+
+		FBinarySpanWriter Span(writer.WriteUninitialized(Size));
+		Span.WriteByte(static_cast<uint8>(EClientMessageType::CallReducer));
+		StdbBsatn::Write(Span, Reducer);
+		Span.WriteInt32(static_cast<int32>(ArgsSize));
+		StdbBsatn::Write(Span, Args);
+		Span.WriteUInt32(RequestId);
+		Span.WriteByte(Flags);
+		check(Span.IsFull());
+	}
+
 	static FClientMessage OneOffQuery(const FOneOffQueryData& data)
 	{
 		FClientMessage Message;
@@ -2,6 +2,7 @@
 #include "CoreMinimal.h"
 #include "FBinaryReader.h"
 #include "FBinaryWriter.h"
+#include "TStdbBsatn.h"
 
 struct SPACETIMEDB_API FQueryId
 {
@@ -17,13 +18,5 @@ struct SPACETIMEDB_API FQueryId
 	{
 	}
 
-	void ReadFields(FBinaryReader& reader)
-	{
-		Id = reader.ReadUInt32();
-	}
-
-	void WriteFields(FBinaryWriter& writer) const
-	{
-		writer.WriteUInt32(Id);
-	}
+	STDB_BSATN_FIELDS(Id)
 };
\ No newline at end of file
@@ -9,6 +9,12 @@
 #include "FStdbConnectionId.h"
 #include "LogStdb.h"
 #include "FQueryId.h"
+#include "FBsatnRowView.h"
+#include "FStdbDecompressor.h"
+#include "FStdbMessageArena.h"
+#include "TStdbBsatn.h"
+#include "Async/ParallelFor.h"
+#include <atomic>
 
 struct FIdentityToken;
 
@@ -27,6 +33,9 @@ enum class EServerMessageType : uint8
 	UnsubscribeMultiApplied
 };
 
+// Row offsets live in the arena of the message they were decoded from, see FServerMessage::Arena
+using FStdbRowOffsets = TStdbArenaArray<uint64>;
+
 struct SPACETIMEDB_API RowSizeHint
 {
 	enum class EHintType : uint8
@@ -47,7 +56,7 @@ struct SPACETIMEDB_API RowSizeHint
 
 	TVariant<
 		uint16, // FixedSize,
-		TArray<uint64> // RowOffsets
+		FStdbRowOffsets // RowOffsets
 	> SizeHint;
 
 	void ReadFields(FBinaryReader& reader)
@@ -65,13 +74,9 @@ struct SPACETIMEDB_API RowSizeHint
 			}
 		case EHintType::RowOffsets:
 			{
-				TArray<uint64> Bytes = reader.ReadArray<uint64>(
-					[](FBinaryReader& R)
-					{
-						return R.ReadUInt64();
-					}
-				);
-				SizeHint.Emplace<TArray<uint64>>(MoveTemp(Bytes));
+				FStdbRowOffsets Offsets;
+				reader.ReadPrimitiveArray(Offsets);
+				SizeHint.Emplace<FStdbRowOffsets>(MoveTemp(Offsets));
 				break;
 			}
 		}
@@ -90,11 +95,8 @@ struct SPACETIMEDB_API RowSizeHint
 			}
 		case EHintType::RowOffsets:
 			{
-				const TArray<uint64>& Offsets = SizeHint.Get<TArray<uint64>>();
-				writer.WriteArray<uint64>(Offsets, [](FBinaryWriter& W, const uint64& V)
-				{
-					W.WriteUInt64(V);
-				});
+				const FStdbRowOffsets& Offsets = SizeHint.Get<FStdbRowOffsets>();
+				writer.WritePrimitiveArray(Offsets);
 				break;
 			}
 		}
@@ -104,27 +106,116 @@ struct SPACETIMEDB_API RowSizeHint
 struct SPACETIMEDB_API FBsatnRowList
 {
 	RowSizeHint SizeHint;
-	TArray<uint8> RowsData;
+	// View into the message payload, see FServerMessage::Payload
+	TArrayView<const uint8> RowsData;
+	// Set by ReadFields when the size hint doesn't delimit rows inside RowsData, the list then holds no rows
+	bool bMalformed = false;
 
-	void ReadFields(FBinaryReader& reader)
+	int32 Num() const
 	{
-		SizeHint.ReadFields(reader);
-		RowsData = reader.ReadArray<uint8>(
-			[](FBinaryReader& R)
+		switch (SizeHint.Type)
+		{
+		case RowSizeHint::EHintType::FixedSize:
+		default:
 			{
-				return R.ReadByte();
+				const uint16 RowSize = SizeHint.SizeHint.Get<uint16>();
+				return RowSize > 0 ? RowsData.Num() / RowSize : 0;
 			}
-		);
+		case RowSizeHint::EHintType::RowOffsets:
+			return SizeHint.SizeHint.Get<FStdbRowOffsets>().Num();
+		}
+	}
+
+	/** Size of every row when the server sent a FixedSize hint, 0 if rows are delimited by offsets */
+	int32 GetFixedRowSize() const
+	{
+		return SizeHint.Type == RowSizeHint::EHintType::FixedSize ? SizeHint.SizeHint.Get<uint16>() : 0;
+	}
+
+	FBsatnRowView GetRow(int32 Index) const
+	{
+		check(Index >= 0 && Index < Num());
+		switch (SizeHint.Type)
+		{
+		case RowSizeHint::EHintType::FixedSize:
+		default:
+			{
+				const uint16 RowSize = SizeHint.SizeHint.Get<uint16>();
+				return FBsatnRowView(RowsData.GetData() + Index * RowSize, RowSize);
+			}
+		case RowSizeHint::EHintType::RowOffsets:
+			{
+				// ReadFields made sure the offsets are ascending and inside RowsData
+				const FStdbRowOffsets& Offsets = SizeHint.SizeHint.Get<FStdbRowOffsets>();
+				const uint64 Start = Offsets[Index];
+				const uint64 End = Index + 1 < Offsets.Num() ? Offsets[Index + 1] : RowsData.Num();
+				return FBsatnRowView(RowsData.GetData() + Start, static_cast<int32>(End - Start));
+			}
+		}
+	}
+
+	/** Decodes every row straight from the payload into OutRows */
+	template<typename TRow>
+	void DecodeRows(TArray<TRow>& OutRows) const
+	{
+		if constexpr (TStdbFixedRowDecoder<TRow>::bEnabled)
+		{
+			if (GetFixedRowSize() > 0 && TStdbFixedRowDecoder<TRow>::Decode(*this, OutRows))
+			{
+				return;
+			}
+		}
+
+		const int32 RowCount = Num();
+		OutRows.Reserve(OutRows.Num() + RowCount);
+		for (int32 i = 0; i < RowCount; ++i)
+		{
+			OutRows.Add(GetRow(i).Decode<TRow>());
+		}
+	}
+
+	void ReadFields(FBinaryReader& reader)
+	{
+		SizeHint.ReadFields(reader);
+		RowsData = reader.ReadByteArrayView();
+
+		// Checked once here so GetRow can slice without bounds checks
+		bMalformed = !HasValidRowBounds();
+		if (bMalformed)
+		{
+			UE_LOG(LogStdb, Error, TEXT("Row list size hint doesn't match its %d bytes of rows"), RowsData.Num());
+			SizeHint.Type = RowSizeHint::EHintType::RowOffsets;
+			SizeHint.SizeHint.Emplace<FStdbRowOffsets>();
+			RowsData = TArrayView<const uint8>();
+		}
 	}
 
 	void WriteFields(FBinaryWriter& writer) const
 	{
 		SizeHint.WriteFields(writer);
-		writer.WriteArray<uint8>(RowsData,
-		                         [](FBinaryWriter& W, const uint8& V)
-		                         {
-			                         return W.WriteByte(V);
-		                         });
+		writer.WritePrimitiveArray(RowsData);
+	}
+
+private:
+	// Fixed-size rows fill RowsData exactly, row offsets ascend and stay inside it
+	bool HasValidRowBounds() const
+	{
+		if (SizeHint.Type != RowSizeHint::EHintType::RowOffsets)
+		{
+			const uint16 RowSize = SizeHint.SizeHint.Get<uint16>();
+			return RowSize > 0 ? RowsData.Num() % RowSize == 0 : RowsData.Num() == 0;
+		}
+
+		uint64 Previous = 0;
+		for (const uint64 Offset : SizeHint.SizeHint.Get<FStdbRowOffsets>())
+		{
+			if (Offset < Previous)
+			{
+				return false;
+			}
+			Previous = Offset;
+		}
+		return Previous <= static_cast<uint64>(RowsData.Num());
 	}
 };
 
@@ -144,6 +235,11 @@ struct SPACETIMEDB_API FQueryUpdate
 		Deletes.WriteFields(writer);
 		Inserts.WriteFields(writer);
 	}
+
+	bool IsMalformed() const
+	{
+		return Deletes.bMalformed || Inserts.bMalformed;
+	}
 };
 
 struct SPACETIMEDB_API FCompressableQueryUpdate
@@ -159,9 +255,43 @@ struct SPACETIMEDB_API FCompressableQueryUpdate
 
 	TVariant<
 		FQueryUpdate, // Uncompressed,
-		TArray<uint8> // Brotli/Gzip,
+		TArrayView<const uint8> // Brotli/Gzip, view into the message payload
 	> Data;
 
+	// Owns the inflated bytes once Decompress() has run, the FQueryUpdate rows point into it
+	FStdbSharedBuffer DecompressedPayload;
+
+	bool IsCompressed() const
+	{
+		return Type == ECompressionType::Brotli || Type == ECompressionType::Gzip;
+	}
+
+	/** Inflates a Brotli/Gzip update in place, leaving an Uncompressed FQueryUpdate behind. False if it failed or its rows are malformed */
+	bool Decompress()
+	{
+		if (!IsCompressed())
+		{
+			return !Data.Get<FQueryUpdate>().IsMalformed();
+		}
+
+		const EStdbCompression Algo = Type == ECompressionType::Brotli ? EStdbCompression::Brotli : EStdbCompression::Gzip;
+		FStdbSharedBuffer Buffer = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+		if (!FStdbDecompressor::Decompress(Algo, Data.Get<TArrayView<const uint8>>(), *Buffer))
+		{
+			UE_LOG(LogStdb, Error, TEXT("Failed to decompress query update"));
+			return false;
+		}
+
+		FBinaryReader Reader(*Buffer);
+		FQueryUpdate Query;
+		Query.ReadFields(Reader);
+		const bool bMalformed = Query.IsMalformed();
+		Data.Emplace<FQueryUpdate>(MoveTemp(Query));
+		Type = ECompressionType::Uncompressed;
+		DecompressedPayload = MoveTemp(Buffer);
+		return !bMalformed;
+	}
+
 	void ReadFields(FBinaryReader& reader)
 	{
 		uint8 messageType = reader.ReadByte();
@@ -179,13 +309,7 @@ struct SPACETIMEDB_API FCompressableQueryUpdate
 		case ECompressionType::Brotli:
 		case ECompressionType::Gzip:
 			{
-				TArray<uint8> Bytes = reader.ReadArray<uint8>(
-					[](FBinaryReader& R)
-					{
-						return R.ReadByte();
-					}
-				);
-				Data.Emplace<TArray<uint8>>(MoveTemp(Bytes));
+				Data.Emplace<TArrayView<const uint8>>(reader.ReadByteArrayView());
 				break;
 			}
 		}
@@ -208,11 +332,8 @@ struct SPACETIMEDB_API FCompressableQueryUpdate
 		case ECompressionType::Brotli:
 		case ECompressionType::Gzip:
 			{
-				const TArray<uint8>& Compressed = Data.Get<TArray<uint8>>();
-				writer.WriteArray<uint8>(Compressed, [](FBinaryWriter& W, const uint8& V)
-				{
-					W.WriteByte(V);
-				});
+				const TArrayView<const uint8>& Compressed = Data.Get<TArrayView<const uint8>>();
+				writer.WritePrimitiveArray(Compressed);
 				break;
 			}
 		}
@@ -222,23 +343,54 @@ struct SPACETIMEDB_API FCompressableQueryUpdate
 struct SPACETIMEDB_API FTableUpdate
 {
 	uint32 TableId;
-	FString TableName;
+	// UTF-8 name, view into the message payload. The client cache resolves tables by TableId
+	FUtf8StringView TableName;
 	uint64 NumRows;
-	TArray<FCompressableQueryUpdate> Updates;
+	TStdbArenaArray<FCompressableQueryUpdate> Updates;
+
+	/** Copies the name out of the payload */
+	FString GetTableName() const
+	{
+		return FBinaryReader::DecodeUtf8(TableName);
+	}
+
+	bool HasCompressedUpdates() const
+	{
+		for (const FCompressableQueryUpdate& Update : Updates)
+		{
+			if (Update.IsCompressed())
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** False as soon as one query update fails to inflate or has malformed rows */
+	bool Decompress()
+	{
+		for (FCompressableQueryUpdate& Update : Updates)
+		{
+			if (!Update.Decompress())
+			{
+				UE_LOG(LogStdb, Error, TEXT("Failed to decode an update of table %s"), *GetTableName());
+				return false;
+			}
+		}
+		return true;
+	}
 
 	void ReadFields(FBinaryReader& reader)
 	{
 		TableId = reader.ReadUInt32();
-		TableName = reader.ReadString();
+		TableName = reader.ReadStringView();
 		NumRows = reader.ReadUInt64();
-		Updates = reader.ReadArray<FCompressableQueryUpdate>(
-			[](FBinaryReader& R)
-			{
-				FCompressableQueryUpdate Update;
-				Update.ReadFields(R);
-				return Update;
-			}
-		);
+		const int32 NumUpdates = FMath::Max(reader.ReadInt32(), 0);
+		Updates.Empty(NumUpdates);
+		for (int32 i = 0; i < NumUpdates; ++i)
+		{
+			Updates.AddDefaulted_GetRef().ReadFields(reader);
+		}
 	}
 
 	void WriteFields(FBinaryWriter& writer) const
@@ -257,18 +409,50 @@ struct SPACETIMEDB_API FTableUpdate
 
 struct SPACETIMEDB_API FDatabaseUpdate
 {
-	TArray<FTableUpdate> Tables;
+	TStdbArenaArray<FTableUpdate> Tables;
 
-	void ReadFields(FBinaryReader& reader)
+	/**
+	 * Inflates every compressed query update, tables are independent so they are decompressed in parallel.
+	 * False if any table failed or has malformed rows, the update is then incomplete and must not be applied.
+	 */
+	bool Decompress()
 	{
-		Tables = reader.ReadArray<FTableUpdate>(
-			[](FBinaryReader& R)
+		std::atomic<bool> bFailed{false};
+		TArray<int32, TInlineAllocator<16>> CompressedTables;
+		for (int32 i = 0; i < Tables.Num(); ++i)
+		{
+			if (Tables[i].HasCompressedUpdates())
 			{
-				FTableUpdate Table;
-				Table.ReadFields(R);
-				return Table;
+				CompressedTables.Add(i);
 			}
-		);
+			else if (!Tables[i].Decompress())
+			{
+				// Nothing to inflate, this only reports rows that failed validation
+				bFailed.store(true, std::memory_order_relaxed);
+			}
+		}
+
+		// Worker threads can't share the message arena, each task decodes into a child of it
+		FStdbMessageArena* Arena = FStdbMessageArena::GetCurrent();
+		ParallelFor(CompressedTables.Num(), [this, &CompressedTables, Arena, &bFailed](int32 Index)
+		{
+			FStdbArenaScope Scope(Arena ? &Arena->CreateChild() : nullptr);
+			if (!Tables[CompressedTables[Index]].Decompress())
+			{
+				bFailed.store(true, std::memory_order_relaxed);
+			}
+		});
+		return !bFailed.load(std::memory_order_relaxed);
+	}
+
+	void ReadFields(FBinaryReader& reader)
+	{
+		const int32 NumTables = FMath::Max(reader.ReadInt32(), 0);
+		Tables.Empty(NumTables);
+		for (int32 i = 0; i < NumTables; ++i)
+		{
+			Tables.AddDefaulted_GetRef().ReadFields(reader);
+		}
 	}
 
 	void WriteFields(FBinaryWriter& writer) const
@@ -412,36 +596,14 @@ struct SPACETIMEDB_API FReducerCallInfo
 	{
 	}
 
-	void ReadFields(FBinaryReader& reader)
-	{
-		ReducerName = reader.ReadString();
-		ReducerId = reader.ReadUInt32();
-		Args = reader.ReadArray<uint8>([](FBinaryReader& R) { return R.ReadByte(); });
-		RequestId = reader.ReadUInt32();
-	}
-
-	void WriteFields(FBinaryWriter& writer) const
-	{
-		writer.WriteString(ReducerName);
-		writer.WriteUInt32(ReducerId);
-		writer.WriteArray<uint8>(Args, [](FBinaryWriter& W, const uint8& V) { W.WriteByte(V); });
-		writer.WriteUInt32(RequestId);
-	}
+	STDB_BSATN_FIELDS(ReducerName, ReducerId, Args, RequestId)
 };
 
 struct SPACETIMEDB_API FEnergyQuanta
 {
 	FU128 Quanta;
 
-	void ReadFields(FBinaryReader& reader)
-	{
-		Quanta = reader.ReadU128();
-	}
-
-	void WriteFields(FBinaryWriter& writer) const
-	{
-		writer.WriteU128(Quanta);
-	}
+	STDB_BSATN_FIELDS(Quanta)
 };
 
 struct SPACETIMEDB_API FTransactionUpdateData
@@ -542,19 +704,7 @@ struct SPACETIMEDB_API FIdentityTokenData
 	FString Token;
 	FStdbConnectionId ConnectionId;
 
-	void ReadFields(FBinaryReader& reader)
-	{
-		Identity = reader.ReadIdentity();
-		Token = reader.ReadString();
-		ConnectionId = reader.ReadConnectionId();
-	}
-
-	void WriteField(FBinaryWriter writer) const
-	{
-		writer.WriteIdentity(Identity);
-		writer.WriteString(Token);
-		writer.WriteConnectionId(ConnectionId);
-	}
+	STDB_BSATN_FIELDS(Identity, Token, ConnectionId)
 };
 
 struct SPACETIMEDB_API FOneOffTable
@@ -613,7 +763,7 @@ struct SPACETIMEDB_API FOneOffQueryResponseData
 
 	void ReadFields(FBinaryReader& reader)
 	{
-		MessageId = reader.ReadArray<uint8>([](FBinaryReader& R) { return R.ReadByte(); });
+		MessageId = reader.ReadPrimitiveArray<uint8>();
 		Error = reader.ReadOptionalString();
 		Tables = reader.ReadArray<FOneOffTable>([](FBinaryReader& R)
 		{
@@ -627,7 +777,7 @@ struct SPACETIMEDB_API FOneOffQueryResponseData
 
 	void WriteFields(FBinaryWriter& writer) const
 	{
-		writer.WriteArray<uint8>(MessageId, [](FBinaryWriter& W, const uint8& Byte) { W.WriteByte(Byte); });
+		writer.WritePrimitiveArray(MessageId);
 		writer.WriteOptionalString(Error);
 		writer.WriteArray<FOneOffTable>(Tables, [](FBinaryWriter& W, const FOneOffTable& Table)
 		{
@@ -643,17 +793,18 @@ struct SPACETIMEDB_API FOneOffQueryResponseData
 struct SPACETIMEDB_API FSubscribeRows
 {
 	uint32 TableId;
-	FString TableName;
+	// UTF-8 name, view into the message payload
+	FUtf8StringView TableName;
 	FTableUpdate TableRows;
 
 	FSubscribeRows()
 		: TableId(0)
-		  , TableName("")
+		  , TableName()
 		  , TableRows()
 	{
 	}
 
-	FSubscribeRows(uint32 InTableId, const FString& InTableName, const FTableUpdate& InTableRows)
+	FSubscribeRows(uint32 InTableId, FUtf8StringView InTableName, const FTableUpdate& InTableRows)
 		: TableId(InTableId)
 		  , TableName(InTableName)
 		  , TableRows(InTableRows)
@@ -663,7 +814,7 @@ struct SPACETIMEDB_API FSubscribeRows
 	void ReadFields(FBinaryReader& reader)
 	{
 		TableId = reader.ReadUInt32();
-		TableName = reader.ReadString();
+		TableName = reader.ReadStringView();
 		TableRows.ReadFields(reader);
 	}
 
@@ -900,6 +1051,9 @@ struct SPACETIMEDB_API FUnsubscribeMultiAppliedData
 
 struct SPACETIMEDB_API FServerMessage
 {
+	// Backs the small arrays decoded for this message, declared first so it is released after them
+	TSharedPtr<FStdbMessageArena, ESPMode::ThreadSafe> Arena;
+
 	EServerMessageType Type;
 	TVariant<
 		FIdentityTokenData,
@@ -913,6 +1067,40 @@ struct SPACETIMEDB_API FServerMessage
 		FSubscribeMultiAppliedData,
 		FUnsubscribeMultiAppliedData> Data;
 
+	// Decoded message bytes; row lists and byte views in Data point into this buffer
+	FStdbSharedBuffer Payload;
+
+	/**
+	 * Inflates the per-table Brotli/Gzip query updates carried by this message. False if any of them
+	 * failed or any row list is malformed, the message then can't be applied without the cache drifting
+	 * from the server.
+	 */
+	bool DecompressQueryUpdates()
+	{
+		switch (Type)
+		{
+		case EServerMessageType::InitialSubscription:
+			return Data.Get<FInitialSubscriptionData>().DatabaseUpdate.Decompress();
+		case EServerMessageType::TransactionUpdate:
+			{
+				FUpdateStatus& Status = Data.Get<FTransactionUpdateData>().Status;
+				return Status.Type != FUpdateStatus::EStatusType::Committed || Status.Data.Get<FDatabaseUpdate>().Decompress();
+			}
+		case EServerMessageType::TransactionUpdateLight:
+			return Data.Get<FTransactionUpdateLightData>().Update.Decompress();
+		case EServerMessageType::SubscribeApplied:
+			return Data.Get<FSubscribeAppliedData>().Rows.TableRows.Decompress();
+		case EServerMessageType::UnsubscribeApplied:
+			return Data.Get<FUnsubscribeAppliedData>().Rows.TableRows.Decompress();
+		case EServerMessageType::SubscribeMultiApplied:
+			return Data.Get<FSubscribeMultiAppliedData>().Update.Decompress();
+		case EServerMessageType::UnsubscribeMultiApplied:
+			return Data.Get<FUnsubscribeMultiAppliedData>().Update.Decompress();
+		default:
+			return true;
+		}
+	}
+
 	static FServerMessage Deserialize(FBinaryReader& reader)
 	{
 		FServerMessage result;
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+#include "Tasks/Pipe.h"
+#include "ClientCache/TStdbTableCache.h"
+#include <atomic>
+
+/**
+ * FStdbCacheDiff: Typed rows of one server message for every registered table it touches.
+ * Built by the decode workers, applied on the game thread.
+ */
+struct SPACETIMEDB_API FStdbCacheDiff
+{
+	struct FTableDiff
+	{
+		IStdbTableCache* Table = nullptr;
+		TUniquePtr<IStdbTableDiff> Diff;
+	};
+
+	TArray<FTableDiff> Tables;
+
+	bool IsEmpty() const { return Tables.Num() == 0; }
+};
+
+/**
+ * FStdbCacheSnapshot: The snapshot enabled tables as of one cache version, consistent across tables.
+ * Tables a transaction didn't touch share their snapshot with the previous version.
+ */
+struct SPACETIMEDB_API FStdbCacheSnapshot
+{
+	// Incremented by every applied diff
+	uint64 Version = 0;
+	TMap<FString, FStdbTableSnapshotPtr> Tables;
+
+	/** TRow and TStorage must be the types the table was registered with */
+	template<typename TRow, typename TStorage = TStdbRowStorage<TRow>>
+	const TStdbTableSnapshot<TRow, TStorage>* GetTable(const FString& TableName) const
+	{
+		const FStdbTableSnapshotPtr* Table = Tables.Find(TableName);
+		return Table ? static_cast<const TStdbTableSnapshot<TRow, TStorage>*>(Table->Get()) : nullptr;
+	}
+};
+
+using FStdbCacheSnapshotPtr = TSharedPtr<const FStdbCacheSnapshot, ESPMode::ThreadSafe>;
+
+/**
+ * FStdbClientCache: Client side copy of the subscribed tables (RemoteTables).
+ * Tables are registered with their row type before connecting; updates for tables that were
+ * never registered are ignored. Rows are decoded into an FStdbCacheDiff on the decode workers,
+ * everything else is only used from the game thread, except GetSnapshot.
+ */
+class SPACETIMEDB_API FStdbClientCache
+{
+public:
+	~FStdbClientCache();
+
+	template<typename TRow, typename TStorage = TStdbRowStorage<TRow>>
+	TStdbTableCache<TRow, TStorage>& RegisterTable(const FString& TableName)
+	{
+		checkf(!bRegistrationLocked, TEXT("Table %s must be registered before connecting, decode workers read the table list"), *TableName);
+		TUniquePtr<IStdbTableCache>& Slot = Tables.FindOrAdd(TableName);
+		checkf(!Slot.IsValid(), TEXT("Table %s is already registered"), *TableName);
+		TStdbTableCache<TRow, TStorage>* Table = new TStdbTableCache<TRow, TStorage>(TableName);
+		Slot.Reset(Table);
+		return *Table;
+	}
+
+	/** TRow and TStorage must be the types the table was registered with */
+	template<typename TRow, typename TStorage = TStdbRowStorage<TRow>>
+	TStdbTableCache<TRow, TStorage>* GetTable(const FString& TableName) const
+	{
+		return static_cast<TStdbTableCache<TRow, TStorage>*>(FindTable(TableName));
+	}
+
+	IStdbTableCache* FindTable(const FString& TableName) const;
+
+	/**
+	 * Table an update belongs to. The name is only looked at the first time a TableId is seen,
+	 * after that the table comes straight out of a flat array indexed by id. Any thread.
+	 */
+	IStdbTableCache* ResolveTable(const FTableUpdate& Update) const;
+
+	/** Called when the connection starts, the table list is read by the decode workers from then on */
+	void LockRegistration();
+
+	/**
+	 * Latest published snapshot of the tables that have EnableSnapshots, safe to call from any thread
+	 * and never blocks. The snapshot stays valid and unchanged for as long as the caller holds it.
+	 * Snapshots are built in the background, so the latest one may trail GetVersion by a few versions.
+	 */
+	FStdbCacheSnapshotPtr GetSnapshot() const;
+
+	uint64 GetVersion() const { return Version; }
+
+	/**
+	 * Decodes the rows of registered tables into OutDiff. Any thread once registration is locked.
+	 * Big updates decode their tables in parallel on the task graph.
+	 */
+	void DecodeDatabaseUpdate(const FDatabaseUpdate& Update, FStdbCacheDiff& OutDiff) const;
+	void DecodeTableUpdate(const FTableUpdate& Update, FStdbCacheDiff& OutDiff) const;
+
+	/** Applies every table of the diff before any row callback runs */
+	void ApplyDiff(FStdbCacheDiff& Diff);
+
+	/** Decodes and applies on the calling thread */
+	void ApplyDatabaseUpdate(const FDatabaseUpdate& Update);
+	void ApplyTableUpdate(const FTableUpdate& Update);
+
+	void Clear();
+
+private:
+	void DecodeTableUpdates(TArrayView<const FTableUpdate> Updates, FStdbCacheDiff& OutDiff) const;
+
+	struct FSnapshotChange
+	{
+		IStdbTableCache* Table = nullptr;
+		// Committed diff of the table, null when it was cleared
+		TUniquePtr<IStdbTableDiff> Diff;
+	};
+
+	/**
+	 * Queues the next version on the snapshot pipe, which patches the Changed tables and shares the rest.
+	 * Changes of tables without snapshots are dropped.
+	 */
+	void PublishSnapshot(TArray<FSnapshotChange>&& Changes);
+	// Snapshot pipe only, apart from the first one in LockRegistration
+	void SwapSnapshot(FStdbCacheSnapshotPtr Next);
+	void FreeRetiredSnapshots();
+
+	TMap<FString, TUniquePtr<IStdbTableCache>> Tables;
+	bool bRegistrationLocked = false;
+
+	struct FResolvedTable
+	{
+		IStdbTableCache* Table = nullptr;
+		bool bResolved = false;
+	};
+
+	// Server table ids learned from the first update of each table, unregistered tables resolve to null
+	mutable FRWLock TableIdLock;
+	mutable TArray<FResolvedTable> TablesById;
+
+	uint64 Version = 0;
+
+	// Builds snapshots one version after the other off the game thread
+	UE::Tasks::FPipe SnapshotPipe{TEXT("FStdbSnapshotPipe")};
+	// Snapshot pipe only, the version the last build started from
+	FStdbCacheSnapshotPtr LastSnapshot;
+
+	/**
+	 * The published snapshot is swapped with an atomic exchange. A reader counts itself in while it
+	 * copies the pointer out of the holder, holders replaced since are only freed once no reader is.
+	 */
+	struct FPublishedSnapshot
+	{
+		FStdbCacheSnapshotPtr Snapshot;
+	};
+	std::atomic<FPublishedSnapshot*> PublishedSnapshot{nullptr};
+	mutable std::atomic<int32> NumSnapshotReaders{0};
+	// Snapshot pipe only
+	TArray<FPublishedSnapshot*> RetiredSnapshots;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * FStdbSparseIndex: Maps u32 keys to dense indices by direct indexing, no hashing.
+ * Meant for #[auto_inc] primary keys, which are small and dense. The sparse array is split
+ * into pages that are only allocated while they hold a key, so ids that keep growing over a
+ * session (food eaten and respawned) don't pin memory for every id ever seen.
+ */
+class FStdbSparseIndex
+{
+public:
+	static constexpr uint32 PageBits = 10;
+	static constexpr uint32 PageSize = 1u << PageBits;
+
+	/** Dense index of Key, INDEX_NONE when it isn't mapped */
+	FORCEINLINE int32 Find(uint32 Key) const
+	{
+		const uint32 PageIndex = Key >> PageBits;
+		if (PageIndex < static_cast<uint32>(Pages.Num()))
+		{
+			const FPage& Page = Pages[PageIndex];
+			if (Page.Slots.Num() > 0)
+			{
+				return Page.Slots[Key & (PageSize - 1)];
+			}
+		}
+		return INDEX_NONE;
+	}
+
+	FORCEINLINE bool Contains(uint32 Key) const { return Find(Key) != INDEX_NONE; }
+
+	/** Maps Key, which must not be mapped yet, to Index */
+	void Add(uint32 Key, int32 Index)
+	{
+		const int32 PageIndex = static_cast<int32>(Key >> PageBits);
+		if (PageIndex >= Pages.Num())
+		{
+			Pages.SetNum(PageIndex + 1);
+		}
+
+		FPage& Page = Pages[PageIndex];
+		if (Page.Slots.Num() == 0)
+		{
+			Page.Slots.Init(INDEX_NONE, PageSize);
+		}
+
+		int32& Slot = Page.Slots[Key & (PageSize - 1)];
+		checkSlow(Slot == INDEX_NONE);
+		Slot = Index;
+		++Page.NumUsed;
+	}
+
+	/** Points an already mapped key at a new dense index, after its row was moved */
+	FORCEINLINE void Update(uint32 Key, int32 Index)
+	{
+		int32& Slot = Pages[Key >> PageBits].Slots[Key & (PageSize - 1)];
+		checkSlow(Slot != INDEX_NONE);
+		Slot = Index;
+	}
+
+	/** Unmaps Key and returns the dense index it had, INDEX_NONE when it wasn't mapped */
+	int32 Remove(uint32 Key)
+	{
+		const uint32 PageIndex = Key >> PageBits;
+		if (PageIndex >= static_cast<uint32>(Pages.Num()) || Pages[PageIndex].Slots.Num() == 0)
+		{
+			return INDEX_NONE;
+		}
+
+		FPage& Page = Pages[PageIndex];
+		int32& Slot = Page.Slots[Key & (PageSize - 1)];
+		const int32 Index = Slot;
+		if (Index != INDEX_NONE)
+		{
+			Slot = INDEX_NONE;
+			if (--Page.NumUsed == 0)
+			{
+				Page.Slots.Empty();
+			}
+		}
+		return Index;
+	}
+
+	void Reset()
+	{
+		Pages.Reset();
+	}
+
+private:
+	struct FPage
+	{
+		// Empty while no key of the page is mapped, PageSize slots otherwise
+		TArray<int32> Slots;
+		int32 NumUsed = 0;
+	};
+
+	TArray<FPage> Pages;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * TStdbRowStorage: Default table storage, whole rows stored densely and indexed by primary key.
+ *
+ * Any storage used with TStdbTableCache provides the same write side:
+ * Num(), Reserve(), Reset(), Remove(Key) returning whether the row existed, AddOrReplace(Row)
+ * returning whether it overwrote a stored row in its slot, and FindRow(Key, OutRow) to copy a stored row out.
+ * The read side is up to the storage, this one hands out rows, column stores hand out columns.
+ */
+template<typename TRow>
+class TStdbRowStorage
+{
+public:
+	using FPrimaryKey = typename TRow::FPrimaryKey;
+
+	int32 Num() const { return Rows.Num(); }
+
+	void Reserve(int32 Number)
+	{
+		Rows.Reserve(Number);
+		RowIndexByKey.Reserve(Number);
+	}
+
+	void Reset()
+	{
+		Rows.Reset();
+		RowIndexByKey.Reset();
+	}
+
+	const TRow* Find(const FPrimaryKey& Key) const
+	{
+		const int32* Index = RowIndexByKey.Find(Key);
+		return Index ? &Rows[*Index] : nullptr;
+	}
+
+	bool Contains(const FPrimaryKey& Key) const
+	{
+		return RowIndexByKey.Contains(Key);
+	}
+
+	bool FindRow(const FPrimaryKey& Key, TRow& OutRow) const
+	{
+		const TRow* Row = Find(Key);
+		if (Row)
+		{
+			OutRow = *Row;
+		}
+		return Row != nullptr;
+	}
+
+	/** Rows in no particular order, contiguous in memory */
+	TArrayView<const TRow> GetRows() const { return Rows; }
+
+	bool Remove(const FPrimaryKey& Key)
+	{
+		int32 Index;
+		if (!RowIndexByKey.RemoveAndCopyValue(Key, Index))
+		{
+			return false;
+		}
+
+		// Swap the last row into the hole to keep storage dense
+		const int32 LastIndex = Rows.Num() - 1;
+		if (Index != LastIndex)
+		{
+			Rows[Index] = MoveTemp(Rows[LastIndex]);
+			RowIndexByKey[Rows[Index].GetPrimaryKey()] = Index;
+		}
+		Rows.Pop(/* bAllowShrinking = */ false);
+		return true;
+	}
+
+	bool AddOrReplace(const TRow& Row)
+	{
+		const FPrimaryKey Key = Row.GetPrimaryKey();
+		if (const int32* Index = RowIndexByKey.Find(Key))
+		{
+			Rows[*Index] = Row;
+			return true;
+		}
+		RowIndexByKey.Add(Key, Rows.Add(Row));
+		return false;
+	}
+
+private:
+	TArray<TRow> Rows;
+	TMap<FPrimaryKey, int32> RowIndexByKey;
+};
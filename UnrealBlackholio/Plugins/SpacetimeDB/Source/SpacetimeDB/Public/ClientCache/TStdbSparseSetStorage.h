@@ -0,0 +1,93 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <type_traits>
+#include "ClientCache/FStdbSparseIndex.h"
+
+/**
+ * TStdbSparseSetStorage: Sparse set of whole rows for tables keyed by an #[auto_inc] u32.
+ * Rows are packed densely like TStdbRowStorage, but the key to row mapping is an FStdbSparseIndex
+ * instead of a TMap, so insert, delete and lookup are an array access without hashing.
+ */
+template<typename TRow>
+class TStdbSparseSetStorage
+{
+public:
+	using FPrimaryKey = typename TRow::FPrimaryKey;
+
+	static_assert(std::is_integral_v<FPrimaryKey> && std::is_unsigned_v<FPrimaryKey> && sizeof(FPrimaryKey) <= sizeof(uint32),
+		"TStdbSparseSetStorage needs an unsigned primary key of at most 32 bits");
+
+	int32 Num() const { return Rows.Num(); }
+
+	void Reserve(int32 Number)
+	{
+		Rows.Reserve(Number);
+	}
+
+	void Reset()
+	{
+		Rows.Reset();
+		RowIndexByKey.Reset();
+	}
+
+	const TRow* Find(FPrimaryKey Key) const
+	{
+		const int32 Index = RowIndexByKey.Find(Key);
+		return Index != INDEX_NONE ? &Rows[Index] : nullptr;
+	}
+
+	bool Contains(FPrimaryKey Key) const
+	{
+		return RowIndexByKey.Contains(Key);
+	}
+
+	bool FindRow(FPrimaryKey Key, TRow& OutRow) const
+	{
+		const TRow* Row = Find(Key);
+		if (Row)
+		{
+			OutRow = *Row;
+		}
+		return Row != nullptr;
+	}
+
+	/** Rows in no particular order, contiguous in memory */
+	TArrayView<const TRow> GetRows() const { return Rows; }
+
+	bool Remove(FPrimaryKey Key)
+	{
+		const int32 Index = RowIndexByKey.Remove(Key);
+		if (Index == INDEX_NONE)
+		{
+			return false;
+		}
+
+		// Swap the last row into the hole to keep storage dense
+		const int32 LastIndex = Rows.Num() - 1;
+		if (Index != LastIndex)
+		{
+			Rows[Index] = MoveTemp(Rows[LastIndex]);
+			RowIndexByKey.Update(Rows[Index].GetPrimaryKey(), Index);
+		}
+		Rows.Pop(/* bAllowShrinking = */ false);
+		return true;
+	}
+
+	bool AddOrReplace(const TRow& Row)
+	{
+		const FPrimaryKey Key = Row.GetPrimaryKey();
+		const int32 Index = RowIndexByKey.Find(Key);
+		if (Index != INDEX_NONE)
+		{
+			Rows[Index] = Row;
+			return true;
+		}
+		RowIndexByKey.Add(Key, Rows.Add(Row));
+		return false;
+	}
+
+private:
+	TArray<TRow> Rows;
+	FStdbSparseIndex RowIndexByKey;
+};
@@ -0,0 +1,477 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ClientApi/FServerMessage.h"
+#include "ClientCache/TStdbRowStorage.h"
+#include "ClientCache/TStdbTableIndex.h"
+#include "ClientCache/TStdbTableSnapshot.h"
+#include <atomic>
+
+/**
+ * IStdbTableDiff: Type erased change set of one table, the rows of its updates decoded into structs.
+ */
+class IStdbTableDiff
+{
+public:
+	virtual ~IStdbTableDiff() = default;
+};
+
+/**
+ * TStdbTableDiff: Rows deleted and inserted by one message. The server sends a changed row as
+ * a delete and an insert with the same primary key; those are matched into an update, so
+ * applying it replaces the row in its slot and it is reported once through OnUpdate.
+ */
+template<typename TRow>
+class TStdbTableDiff : public IStdbTableDiff
+{
+public:
+	using FPrimaryKey = typename TRow::FPrimaryKey;
+
+	struct FRowUpdate
+	{
+		TRow OldRow;
+		TRow NewRow;
+	};
+
+	TArray<TRow> Deletes;
+	TArray<TRow> Inserts;
+	TArray<FRowUpdate> Updates;
+
+	/** Moves every delete whose key is inserted again into Updates */
+	void MatchUpdates()
+	{
+		if (Deletes.Num() == 0 || Inserts.Num() == 0)
+		{
+			return;
+		}
+
+		TMap<FPrimaryKey, int32> DeleteByKey;
+		DeleteByKey.Reserve(Deletes.Num());
+		for (int32 i = 0; i < Deletes.Num(); ++i)
+		{
+			DeleteByKey.Add(Deletes[i].GetPrimaryKey(), i);
+		}
+
+		TBitArray<> Matched(false, Deletes.Num());
+		int32 NumInserts = 0;
+		for (int32 i = 0; i < Inserts.Num(); ++i)
+		{
+			int32 DeleteIndex;
+			if (DeleteByKey.RemoveAndCopyValue(Inserts[i].GetPrimaryKey(), DeleteIndex))
+			{
+				Updates.Add({MoveTemp(Deletes[DeleteIndex]), MoveTemp(Inserts[i])});
+				Matched[DeleteIndex] = true;
+			}
+			else
+			{
+				if (NumInserts != i)
+				{
+					Inserts[NumInserts] = MoveTemp(Inserts[i]);
+				}
+				++NumInserts;
+			}
+		}
+		Inserts.SetNum(NumInserts, /* bAllowShrinking = */ false);
+
+		int32 NumDeletes = 0;
+		for (int32 i = 0; i < Deletes.Num(); ++i)
+		{
+			if (!Matched[i])
+			{
+				if (NumDeletes != i)
+				{
+					Deletes[NumDeletes] = MoveTemp(Deletes[i]);
+				}
+				++NumDeletes;
+			}
+		}
+		Deletes.SetNum(NumDeletes, /* bAllowShrinking = */ false);
+	}
+};
+
+/**
+ * IStdbTableCache: Type erased client side copy of one remote table.
+ * Updates are applied in three steps so a transaction touching several tables lands as a whole:
+ * every table decodes its rows into a diff, then every table commits its diff, then callbacks
+ * run against the final state. Decoding touches no cache state, so it runs on the decode workers.
+ */
+class SPACETIMEDB_API IStdbTableCache
+{
+public:
+	virtual ~IStdbTableCache() = default;
+
+	virtual const FString& GetTableName() const = 0;
+	virtual int32 Num() const = 0;
+
+	/** Decodes the rows of an update for this table into InOutDiff, creating it if needed. Any thread. */
+	virtual void DecodeUpdate(const FTableUpdate& Update, TUniquePtr<IStdbTableDiff>& InOutDiff) const = 0;
+
+	/** Decoding is done, matches deletes and inserts into updates. Any thread. */
+	virtual void FinishDiff(IStdbTableDiff& Diff) const = 0;
+
+	/**
+	 * Applies a diff to the stored rows. Deletes and inserts that only change how many
+	 * subscriptions hold a row are dropped from the diff, so callbacks see rows entering
+	 * and leaving the cache.
+	 */
+	virtual void CommitDiff(IStdbTableDiff& Diff) = 0;
+
+	/** Runs row callbacks for a committed diff, an updated row fires OnUpdate instead of OnDelete and OnInsert */
+	virtual void BroadcastDiff(const IStdbTableDiff& Diff) = 0;
+
+	/** Whether the cache publishes snapshots of this table */
+	virtual bool HasSnapshots() const = 0;
+
+	/** First snapshot, a copy of the rows stored now. Game thread, before any BuildSnapshot. */
+	virtual FStdbTableSnapshotPtr SeedSnapshot(uint64 Version) = 0;
+
+	/**
+	 * Next snapshot: the previous one with a committed diff applied, a null diff for a cleared table.
+	 * A table that was never seeded starts from an empty one.
+	 * Only touches the table's snapshots, not its rows, so it runs on the cache's snapshot pipe
+	 * while the game thread carries on.
+	 */
+	virtual FStdbTableSnapshotPtr BuildSnapshot(uint64 Version, TUniquePtr<IStdbTableDiff> Diff) = 0;
+
+	virtual void Clear() = 0;
+};
+
+/**
+ * TStdbTableCache: Client side copy of one table.
+ * TRow decodes itself with ReadFields(FBinaryReader&) and exposes its key through
+ * a nested FPrimaryKey type and GetPrimaryKey(). TStorage decides the memory layout,
+ * see TStdbRowStorage for what it has to provide.
+ * Secondary indexes mirror the server's #[unique] and #[index(btree)] columns and have to be
+ * added before the first update is applied.
+ * Overlapping subscriptions each send the rows they share, a row is stored once and only
+ * removed when the last subscription holding it lets go.
+ */
+template<typename TRow, typename TStorage = TStdbRowStorage<TRow>>
+class TStdbTableCache : public IStdbTableCache
+{
+public:
+	using FPrimaryKey = typename TRow::FPrimaryKey;
+	using FDiff = TStdbTableDiff<TRow>;
+	using FSnapshot = TStdbTableSnapshot<TRow, TStorage>;
+	using FOnRow = TMulticastDelegate<void(const TRow& /*Row*/)>;
+	using FOnRowUpdate = TMulticastDelegate<void(const TRow& /*OldRow*/, const TRow& /*NewRow*/)>;
+
+	explicit TStdbTableCache(const FString& InTableName)
+		: TableName(InTableName)
+	{
+	}
+
+	virtual const FString& GetTableName() const override { return TableName; }
+	virtual int32 Num() const override { return Storage.Num(); }
+
+	const TStorage& GetStorage() const { return Storage; }
+
+	// Row accessors for storages that keep whole rows
+	const TRow* Find(const FPrimaryKey& Key) const { return Storage.Find(Key); }
+	bool Contains(const FPrimaryKey& Key) const { return Storage.Contains(Key); }
+	TArrayView<const TRow> GetRows() const { return Storage.GetRows(); }
+
+	auto begin() const { return Storage.GetRows().begin(); }
+	auto end() const { return Storage.GetRows().end(); }
+
+	template<typename TKey>
+	TStdbUniqueIndex<TRow, TKey>& AddUniqueIndex(FName IndexName, TKey TRow::* Member)
+	{
+		return AddIndex<TStdbUniqueIndex<TRow, TKey>>(IndexName, Member);
+	}
+
+	template<typename TKey>
+	TStdbBTreeIndex<TRow, TKey>& AddBTreeIndex(FName IndexName, TKey TRow::* Member)
+	{
+		return AddIndex<TStdbBTreeIndex<TRow, TKey>>(IndexName, Member);
+	}
+
+	/** TIndex must be the index type that was added under IndexName */
+	template<typename TIndex>
+	const TIndex* FindIndex(FName IndexName) const
+	{
+		TStdbTableIndex<TRow>* const* Index = IndexesByName.Find(IndexName);
+		return Index ? static_cast<const TIndex*>(*Index) : nullptr;
+	}
+
+	/**
+	 * Publishes a copy of the table in every FStdbCacheSnapshot, for readers off the game thread.
+	 * Copies are patched with the rows each transaction changed off the game thread, but a copy
+	 * a reader still holds has to be copied whole again, so enable it only where it is needed.
+	 * Works before or after connecting, as long as no rows are stored yet.
+	 */
+	void EnableSnapshots()
+	{
+		checkf(Storage.Num() == 0, TEXT("Snapshots of %s must be enabled before rows are applied"), *TableName);
+		bSnapshots = true;
+	}
+
+	virtual bool HasSnapshots() const override { return bSnapshots; }
+
+	virtual FStdbTableSnapshotPtr SeedSnapshot(uint64 Version) override
+	{
+		SnapshotBuffers[0] = MakeShared<FSnapshot, ESPMode::ThreadSafe>(Version, Storage);
+		SnapshotBuffers[1].Reset();
+		PublishedBuffer = 0;
+		LastSnapshotDiff.Reset();
+		return SnapshotBuffers[0];
+	}
+
+	virtual FStdbTableSnapshotPtr BuildSnapshot(uint64 Version, TUniquePtr<IStdbTableDiff> Diff) override
+	{
+		// Enabled after SeedSnapshot ran for the others: the table was empty then, and every diff since comes through here
+		if (!SnapshotBuffers[PublishedBuffer].IsValid())
+		{
+			SnapshotBuffers[PublishedBuffer] = MakeShared<FSnapshot, ESPMode::ThreadSafe>(Version, TStorage());
+		}
+
+		// Two buffers take turns, the one that isn't published is only behind by the last diff
+		const int32 Next = 1 - PublishedBuffer;
+		TSharedPtr<FSnapshot, ESPMode::ThreadSafe>& Buffer = SnapshotBuffers[Next];
+		if (Buffer.IsValid() && Buffer.GetSharedReferenceCount() == 1)
+		{
+			// Readers drop their references with release semantics, their reads are done before the patch
+			std::atomic_thread_fence(std::memory_order_acquire);
+			PatchStorage(Buffer->Storage, LastSnapshotDiff.Get());
+		}
+		else
+		{
+			// Still read somewhere, that copy stays as it is and a new one starts off the published rows
+			Buffer = MakeShared<FSnapshot, ESPMode::ThreadSafe>(Version, SnapshotBuffers[PublishedBuffer]->Storage);
+		}
+
+		PatchStorage(Buffer->Storage, Diff.Get());
+		Buffer->Version = Version;
+		PublishedBuffer = Next;
+		LastSnapshotDiff = MoveTemp(Diff);
+		return Buffer;
+	}
+
+	FOnRow OnInsert;
+	FOnRow OnDelete;
+	/** A row was replaced by one with the same primary key, fired instead of OnDelete and OnInsert */
+	FOnRowUpdate OnUpdate;
+
+	virtual void DecodeUpdate(const FTableUpdate& Update, TUniquePtr<IStdbTableDiff>& InOutDiff) const override
+	{
+		if (!InOutDiff.IsValid())
+		{
+			InOutDiff = MakeUnique<FDiff>();
+		}
+		FDiff& Diff = static_cast<FDiff&>(*InOutDiff);
+
+		for (const FCompressableQueryUpdate& QueryUpdate : Update.Updates)
+		{
+			if (!QueryUpdate.Data.IsType<FQueryUpdate>())
+			{
+				UE_LOG(LogStdb, Warning, TEXT("Skipping undecoded query update for table %s"), *TableName);
+				continue;
+			}
+
+			const FQueryUpdate& Query = QueryUpdate.Data.Get<FQueryUpdate>();
+			Query.Deletes.DecodeRows(Diff.Deletes);
+			Query.Inserts.DecodeRows(Diff.Inserts);
+		}
+	}
+
+	virtual void FinishDiff(IStdbTableDiff& Diff) const override
+	{
+		static_cast<FDiff&>(Diff).MatchUpdates();
+	}
+
+	virtual void CommitDiff(IStdbTableDiff& InDiff) override
+	{
+		FDiff& Diff = static_cast<FDiff&>(InDiff);
+
+		// Only rows that were actually present and aren't held by another subscription count as deleted
+		int32 NumDeleted = 0;
+		for (int32 i = 0; i < Diff.Deletes.Num(); ++i)
+		{
+			const FPrimaryKey Key = Diff.Deletes[i].GetPrimaryKey();
+			if (ReleaseExtraRef(Key))
+			{
+				continue;
+			}
+
+			if (Storage.Remove(Key))
+			{
+				for (const TUniquePtr<TStdbTableIndex<TRow>>& Index : Indexes)
+				{
+					Index->OnDelete(Diff.Deletes[i]);
+				}
+				if (NumDeleted != i)
+				{
+					Diff.Deletes[NumDeleted] = MoveTemp(Diff.Deletes[i]);
+				}
+				++NumDeleted;
+			}
+		}
+		Diff.Deletes.SetNum(NumDeleted, /* bAllowShrinking = */ false);
+
+		// Updated rows are overwritten in their slot, indexes only move entries whose column changed.
+		// An update of a row that wasn't stored is an insert, it is reported as one after the others
+		TArray<TRow> InsertedByUpdate;
+		int32 NumUpdated = 0;
+		for (int32 i = 0; i < Diff.Updates.Num(); ++i)
+		{
+			typename FDiff::FRowUpdate& Update = Diff.Updates[i];
+			if (!Storage.AddOrReplace(Update.NewRow))
+			{
+				for (const TUniquePtr<TStdbTableIndex<TRow>>& Index : Indexes)
+				{
+					Index->OnInsert(Update.NewRow);
+				}
+				InsertedByUpdate.Add(MoveTemp(Update.NewRow));
+				continue;
+			}
+
+			for (const TUniquePtr<TStdbTableIndex<TRow>>& Index : Indexes)
+			{
+				Index->OnUpdate(Update.OldRow, Update.NewRow);
+			}
+			if (NumUpdated != i)
+			{
+				Diff.Updates[NumUpdated] = MoveTemp(Update);
+			}
+			++NumUpdated;
+		}
+		Diff.Updates.SetNum(NumUpdated, /* bAllowShrinking = */ false);
+
+		Storage.Reserve(Storage.Num() + Diff.Inserts.Num());
+		int32 NumInserted = 0;
+		for (int32 i = 0; i < Diff.Inserts.Num(); ++i)
+		{
+			// A row that is already stored came in through another subscription, it is the same row
+			// so overwriting it leaves the indexes as they are and it only gains a reference
+			const TRow& Row = Diff.Inserts[i];
+			if (Storage.AddOrReplace(Row))
+			{
+				++ExtraRefs.FindOrAdd(Row.GetPrimaryKey());
+				continue;
+			}
+
+			for (const TUniquePtr<TStdbTableIndex<TRow>>& Index : Indexes)
+			{
+				Index->OnInsert(Row);
+			}
+			if (NumInserted != i)
+			{
+				Diff.Inserts[NumInserted] = MoveTemp(Diff.Inserts[i]);
+			}
+			++NumInserted;
+		}
+		Diff.Inserts.SetNum(NumInserted, /* bAllowShrinking = */ false);
+		Diff.Inserts.Append(MoveTemp(InsertedByUpdate));
+	}
+
+	virtual void BroadcastDiff(const IStdbTableDiff& InDiff) override
+	{
+		const FDiff& Diff = static_cast<const FDiff&>(InDiff);
+
+		if (OnDelete.IsBound())
+		{
+			for (const TRow& Row : Diff.Deletes)
+			{
+				OnDelete.Broadcast(Row);
+			}
+		}
+		if (OnUpdate.IsBound())
+		{
+			for (const typename FDiff::FRowUpdate& Update : Diff.Updates)
+			{
+				OnUpdate.Broadcast(Update.OldRow, Update.NewRow);
+			}
+		}
+		if (OnInsert.IsBound())
+		{
+			for (const TRow& Row : Diff.Inserts)
+			{
+				OnInsert.Broadcast(Row);
+			}
+		}
+	}
+
+	virtual void Clear() override
+	{
+		Storage.Reset();
+		ExtraRefs.Reset();
+		for (const TUniquePtr<TStdbTableIndex<TRow>>& Index : Indexes)
+		{
+			Index->Reset();
+		}
+	}
+
+protected:
+	/** Replays a committed diff, after CommitDiff it only holds rows that entered, changed or left the table */
+	static void PatchStorage(TStorage& Target, const IStdbTableDiff* InDiff)
+	{
+		if (!InDiff)
+		{
+			Target.Reset();
+			return;
+		}
+
+		const FDiff& Diff = static_cast<const FDiff&>(*InDiff);
+		for (const TRow& Row : Diff.Deletes)
+		{
+			Target.Remove(Row.GetPrimaryKey());
+		}
+		for (const typename FDiff::FRowUpdate& Update : Diff.Updates)
+		{
+			Target.AddOrReplace(Update.NewRow);
+		}
+		Target.Reserve(Target.Num() + Diff.Inserts.Num());
+		for (const TRow& Row : Diff.Inserts)
+		{
+			Target.AddOrReplace(Row);
+		}
+	}
+
+	/** Drops one of the extra references to a row, false when a single subscription holds it */
+	bool ReleaseExtraRef(const FPrimaryKey& Key)
+	{
+		// Empty unless subscriptions overlap, which keeps the common case to this check
+		if (ExtraRefs.Num() == 0)
+		{
+			return false;
+		}
+
+		int32* Refs = ExtraRefs.Find(Key);
+		if (!Refs)
+		{
+			return false;
+		}
+		if (--*Refs == 0)
+		{
+			ExtraRefs.Remove(Key);
+		}
+		return true;
+	}
+
+	template<typename TIndex, typename TKey>
+	TIndex& AddIndex(FName IndexName, TKey TRow::* Member)
+	{
+		checkf(Storage.Num() == 0, TEXT("Indexes on %s must be added before rows are applied"), *TableName);
+		checkf(!IndexesByName.Contains(IndexName), TEXT("Index %s on %s already exists"), *IndexName.ToString(), *TableName);
+		TIndex* Index = new TIndex(Member);
+		Indexes.Emplace(Index);
+		IndexesByName.Add(IndexName, Index);
+		return *Index;
+	}
+
+	const FString TableName;
+
+	TStorage Storage;
+	// Subscriptions holding a row beyond the first, only rows shared by overlapping subscriptions have an entry
+	TMap<FPrimaryKey, int32> ExtraRefs;
+
+	TArray<TUniquePtr<TStdbTableIndex<TRow>>> Indexes;
+	TMap<FName, TStdbTableIndex<TRow>*> IndexesByName;
+
+	bool bSnapshots = false;
+	// Snapshot pipe only, apart from SeedSnapshot
+	TSharedPtr<FSnapshot, ESPMode::ThreadSafe> SnapshotBuffers[2];
+	int32 PublishedBuffer = 0;
+	// Diff the unpublished buffer is missing, null when the table was cleared
+	TUniquePtr<IStdbTableDiff> LastSnapshotDiff;
+};
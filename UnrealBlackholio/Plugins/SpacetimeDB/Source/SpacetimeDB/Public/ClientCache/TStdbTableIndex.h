@@ -0,0 +1,189 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Algo/BinarySearch.h"
+
+/**
+ * TStdbTableIndex: Secondary index over a cached table, kept up to date row by row as
+ * the table commits. Indexes map a column value to primary keys; rows are then looked
+ * up through the table's storage.
+ */
+template<typename TRow>
+class TStdbTableIndex
+{
+public:
+	virtual ~TStdbTableIndex() = default;
+
+	virtual void OnInsert(const TRow& Row) = 0;
+	virtual void OnDelete(const TRow& Row) = 0;
+
+	/** A stored row was replaced by one with the same primary key */
+	virtual void OnUpdate(const TRow& OldRow, const TRow& NewRow)
+	{
+		OnDelete(OldRow);
+		OnInsert(NewRow);
+	}
+
+	virtual void Reset() = 0;
+};
+
+/**
+ * TStdbUniqueIndex: Mirrors a #[unique] column, at most one row per value.
+ */
+template<typename TRow, typename TKey>
+class TStdbUniqueIndex : public TStdbTableIndex<TRow>
+{
+public:
+	using FPrimaryKey = typename TRow::FPrimaryKey;
+
+	explicit TStdbUniqueIndex(TKey TRow::* InMember)
+		: Member(InMember)
+	{
+	}
+
+	const FPrimaryKey* Find(const TKey& Key) const
+	{
+		return PrimaryKeys.Find(Key);
+	}
+
+	int32 Num() const { return PrimaryKeys.Num(); }
+
+	virtual void OnInsert(const TRow& Row) override
+	{
+		PrimaryKeys.Add(Row.*Member, Row.GetPrimaryKey());
+	}
+
+	virtual void OnDelete(const TRow& Row) override
+	{
+		PrimaryKeys.Remove(Row.*Member);
+	}
+
+	virtual void OnUpdate(const TRow& OldRow, const TRow& NewRow) override
+	{
+		// Same primary key, so an unchanged column leaves the entry as it is
+		if (!(OldRow.*Member == NewRow.*Member))
+		{
+			OnDelete(OldRow);
+			OnInsert(NewRow);
+		}
+	}
+
+	virtual void Reset() override
+	{
+		PrimaryKeys.Reset();
+	}
+
+private:
+	TKey TRow::* Member;
+	TMap<TKey, FPrimaryKey> PrimaryKeys;
+};
+
+/**
+ * TStdbBTreeIndex: Mirrors an #[index(btree)] column. Values are kept sorted so both
+ * equality lookups and range scans are a binary search instead of a table scan.
+ *
+ * The ordered structure is a sorted array of one bucket per distinct value rather than a tree.
+ * Adding or dropping a value shifts the buckets after it, O(distinct values), while rows joining
+ * or leaving a value that is already there only touch its bucket. Indexed columns like
+ * circle.player_id have few distinct values that rarely come and go, so the shifts are a short
+ * memmove, and lookups and range scans walk contiguous memory. SpacetimeDB.Benchmark.BTreeIndex
+ * measures both against scanning the table.
+ */
+template<typename TRow, typename TKey>
+class TStdbBTreeIndex : public TStdbTableIndex<TRow>
+{
+public:
+	using FPrimaryKey = typename TRow::FPrimaryKey;
+
+	explicit TStdbBTreeIndex(TKey TRow::* InMember)
+		: Member(InMember)
+	{
+	}
+
+	/** Primary keys of every row whose column equals Key, in no particular order */
+	TArrayView<const FPrimaryKey> Find(const TKey& Key) const
+	{
+		const int32 Index = LowerBound(Key);
+		if (Index < Buckets.Num() && Buckets[Index].Key == Key)
+		{
+			return Buckets[Index].PrimaryKeys;
+		}
+		return TArrayView<const FPrimaryKey>();
+	}
+
+	/** Calls Func(Key, PrimaryKey) for every row with Min <= column <= Max, in column order */
+	template<typename FuncType>
+	void ForEachInRange(const TKey& Min, const TKey& Max, FuncType&& Func) const
+	{
+		for (int32 Index = LowerBound(Min); Index < Buckets.Num() && !(Max < Buckets[Index].Key); ++Index)
+		{
+			for (const FPrimaryKey& PrimaryKey : Buckets[Index].PrimaryKeys)
+			{
+				Func(Buckets[Index].Key, PrimaryKey);
+			}
+		}
+	}
+
+	/** Number of distinct values */
+	int32 NumKeys() const { return Buckets.Num(); }
+
+	virtual void OnInsert(const TRow& Row) override
+	{
+		const TKey& Key = Row.*Member;
+		const int32 Index = LowerBound(Key);
+		if (Index < Buckets.Num() && Buckets[Index].Key == Key)
+		{
+			Buckets[Index].PrimaryKeys.Add(Row.GetPrimaryKey());
+			return;
+		}
+
+		FBucket& Bucket = Buckets.InsertDefaulted_GetRef(Index);
+		Bucket.Key = Key;
+		Bucket.PrimaryKeys.Add(Row.GetPrimaryKey());
+	}
+
+	virtual void OnDelete(const TRow& Row) override
+	{
+		const TKey& Key = Row.*Member;
+		const int32 Index = LowerBound(Key);
+		if (Index < Buckets.Num() && Buckets[Index].Key == Key)
+		{
+			Buckets[Index].PrimaryKeys.RemoveSingleSwap(Row.GetPrimaryKey(), /* bAllowShrinking = */ false);
+			if (Buckets[Index].PrimaryKeys.Num() == 0)
+			{
+				Buckets.RemoveAt(Index, 1, /* bAllowShrinking = */ false);
+			}
+		}
+	}
+
+	virtual void OnUpdate(const TRow& OldRow, const TRow& NewRow) override
+	{
+		// Most updates move a row without touching the indexed column, its bucket stays as it is
+		if (!(OldRow.*Member == NewRow.*Member))
+		{
+			OnDelete(OldRow);
+			OnInsert(NewRow);
+		}
+	}
+
+	virtual void Reset() override
+	{
+		Buckets.Reset();
+	}
+
+private:
+	struct FBucket
+	{
+		TKey Key;
+		TArray<FPrimaryKey> PrimaryKeys;
+	};
+
+	int32 LowerBound(const TKey& Key) const
+	{
+		return Algo::LowerBoundBy(Buckets, Key, &FBucket::Key);
+	}
+
+	TKey TRow::* Member;
+	// Sorted by Key
+	TArray<FBucket> Buckets;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * IStdbTableSnapshot: Type erased, immutable copy of one table as of a cache version.
+ */
+class IStdbTableSnapshot
+{
+public:
+	explicit IStdbTableSnapshot(uint64 InVersion)
+		: Version(InVersion)
+	{
+	}
+
+	virtual ~IStdbTableSnapshot() = default;
+
+	/** Cache version this copy was taken at, see FStdbCacheSnapshot */
+	uint64 GetVersion() const { return Version; }
+
+protected:
+	// Only changed by the snapshot builder while nobody else holds the snapshot
+	uint64 Version;
+};
+
+using FStdbTableSnapshotPtr = TSharedPtr<const IStdbTableSnapshot, ESPMode::ThreadSafe>;
+
+template<typename TRow, typename TStorage>
+class TStdbTableCache;
+
+/**
+ * TStdbTableSnapshot: Copy of a table's storage that never changes while it is published,
+ * so any thread can read it without locks for as long as it holds the pointer.
+ * Once every reader let go of it the owning table patches it up to a later version and reuses it.
+ */
+template<typename TRow, typename TStorage>
+class TStdbTableSnapshot : public IStdbTableSnapshot
+{
+public:
+	using FPrimaryKey = typename TRow::FPrimaryKey;
+
+	TStdbTableSnapshot(uint64 InVersion, const TStorage& InStorage)
+		: IStdbTableSnapshot(InVersion)
+		  , Storage(InStorage)
+	{
+	}
+
+	const TStorage& GetStorage() const { return Storage; }
+	int32 Num() const { return Storage.Num(); }
+
+	// Row accessors for storages that keep whole rows
+	const TRow* Find(const FPrimaryKey& Key) const { return Storage.Find(Key); }
+	TArrayView<const TRow> GetRows() const { return Storage.GetRows(); }
+
+private:
+	friend class TStdbTableCache<TRow, TStorage>;
+
+	TStorage Storage;
+};
@@ -1,6 +1,8 @@
 ﻿#pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/StringView.h"
+#include <type_traits>
 #include "FI128.h"
 #include "FI256.h"
 #include "FU128.h"
@@ -15,7 +17,9 @@ class SPACETIMEDB_API FBinaryReader
 {
 public:
     FBinaryReader(uint8* InData, int64 InSize, bool bInOwnsData = false);
+    FBinaryReader(const uint8* InData, int64 InSize);
     FBinaryReader(const TArray<uint8>& InData);
+    FBinaryReader(TArrayView<const uint8> InData);
     
     ~FBinaryReader();
     
@@ -26,6 +30,12 @@ public:
     void SetPosition(int64 NewPosition);
     
     void ReadBytes(void* OutData, int64 Count);
+
+    // Returns a view of the next Count bytes without copying them; valid as long as the underlying data is
+    TArrayView<const uint8> ReadBytesView(int64 Count);
+
+    // Reads a length-prefixed byte array as a view into the underlying data
+    TArrayView<const uint8> ReadByteArrayView();
     
     bool ReadBool();
     
@@ -61,6 +71,12 @@ public:
     
     FString ReadString();
     TOptional<FString> ReadOptionalString();
+
+    // Reads a string as a view of its UTF-8 bytes without converting or copying them; valid as long as the underlying data is
+    FUtf8StringView ReadStringView();
+
+    // UTF-8 to FString in one pass, pure ASCII input (the common case) is widened without going through the decoder
+    static FString DecodeUtf8(FUtf8StringView Utf8);
     
     FI128 ReadI128();
     TOptional<FI128> ReadOptionalI128();
@@ -102,8 +118,38 @@ public:
     }
     
     TArray<FString> ReadStringArray();
+
+    // Bulk path for arrays of trivially copyable elements: one bounds check and one memcpy for the whole array
     template<typename T>
-    TArray<T> ReadPrimitiveArray();
+    TArray<T> ReadPrimitiveArray()
+    {
+        TArray<T> Result;
+        ReadPrimitiveArray(Result);
+        return Result;
+    }
+
+    // Same as above but reads into an existing array, so the caller picks the allocator
+    template<typename T, typename AllocatorType>
+    void ReadPrimitiveArray(TArray<T, AllocatorType>& OutArray)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "ReadPrimitiveArray requires a trivially copyable element type");
+        static_assert(PLATFORM_LITTLE_ENDIAN, "BSATN is little-endian; ReadPrimitiveArray copies elements as-is");
+
+        int32 Length = ReadInt32();
+
+        OutArray.Reset();
+        if (Length <= 0)
+        {
+            return;
+        }
+
+        const int64 NumBytes = static_cast<int64>(Length) * sizeof(T);
+        EnsureRemaining(NumBytes);
+
+        OutArray.SetNumUninitialized(Length);
+        FMemory::Memcpy(OutArray.GetData(), Data + Position, NumBytes);
+        Position += NumBytes;
+    }
     
 private:
     uint8* Data;
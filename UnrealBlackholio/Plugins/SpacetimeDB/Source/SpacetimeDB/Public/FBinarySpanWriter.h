@@ -0,0 +1,119 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StringView.h"
+#include <type_traits>
+#include "FI128.h"
+#include "FI256.h"
+#include "FU128.h"
+#include "FU256.h"
+#include "FStdbConnectionId.h"
+#include "FStdbIdentity.h"
+#include "FTimeDuration.h"
+#include "FTimestamp.h"
+
+/**
+ * FBinarySpanWriter: Writes BSATN into a span whose size was computed up front with TStdbBsatn::Size,
+ * see FBinaryWriter::WriteUninitialized. Same encoding as FBinaryWriter, but no capacity checks or
+ * growth per write; overrunning the span is a bug in the size calculation and only caught by checkSlow.
+ */
+class FBinarySpanWriter
+{
+public:
+    explicit FBinarySpanWriter(TArrayView<uint8> InSpan)
+        : Cursor(InSpan.GetData())
+        , End(InSpan.GetData() + InSpan.Num())
+    {
+    }
+
+    /** True once exactly the whole span has been written */
+    bool IsFull() const { return Cursor == End; }
+
+    FORCEINLINE void WriteBytes(const void* InData, int64 Count)
+    {
+        checkSlow(Cursor + Count <= End);
+        FMemory::Memcpy(Cursor, InData, Count);
+        Cursor += Count;
+    }
+
+    FORCEINLINE void WriteBool(bool Value) { WriteByte(Value ? 1 : 0); }
+    FORCEINLINE void WriteByte(uint8 Value) { WriteBytes(&Value, 1); }
+    FORCEINLINE void WriteSByte(int8 Value) { WriteBytes(&Value, 1); }
+    FORCEINLINE void WriteInt16(int16 Value) { WriteBytes(&Value, 2); }
+    FORCEINLINE void WriteUInt16(uint16 Value) { WriteBytes(&Value, 2); }
+    FORCEINLINE void WriteInt32(int32 Value) { WriteBytes(&Value, 4); }
+    FORCEINLINE void WriteUInt32(uint32 Value) { WriteBytes(&Value, 4); }
+    FORCEINLINE void WriteInt64(int64 Value) { WriteBytes(&Value, 8); }
+    FORCEINLINE void WriteUInt64(uint64 Value) { WriteBytes(&Value, 8); }
+    FORCEINLINE void WriteFloat(float Value) { WriteBytes(&Value, 4); }
+    FORCEINLINE void WriteDouble(double Value) { WriteBytes(&Value, 8); }
+
+    // Word order matches FBinaryWriter
+    FORCEINLINE void WriteI128(const FI128& Value)
+    {
+        WriteUInt64(Value.GetUpper());
+        WriteUInt64(Value.GetLower());
+    }
+
+    FORCEINLINE void WriteU128(const FU128& Value)
+    {
+        WriteUInt64(Value.GetUpper());
+        WriteUInt64(Value.GetLower());
+    }
+
+    FORCEINLINE void WriteI256(const FI256& Value)
+    {
+        WriteI128(Value.GetUpper());
+        WriteI128(Value.GetLower());
+    }
+
+    FORCEINLINE void WriteU256(const FU256& Value)
+    {
+        WriteU128(Value.GetUpper());
+        WriteU128(Value.GetLower());
+    }
+
+    FORCEINLINE void WriteTimeDuration(const FTimeDuration& Value) { WriteInt64(Value.GetMicros()); }
+    FORCEINLINE void WriteTimestamp(const FTimestamp& Value) { WriteInt64(Value.GetMicros()); }
+    FORCEINLINE void WriteConnectionId(const FStdbConnectionId& Value) { WriteU128(Value.GetValue()); }
+    FORCEINLINE void WriteIdentity(const FStdbIdentity& Value) { WriteU256(Value.GetValue()); }
+
+    // Converts straight into the span, the length is the one TStdbBsatn<FString>::Size accounted for
+    void WriteString(const FString& Value)
+    {
+        const int32 Length = FPlatformString::ConvertedLength<UTF8CHAR>(*Value, Value.Len());
+        WriteInt32(Length);
+        if (Length > 0)
+        {
+            checkSlow(Cursor + Length <= End);
+            FPlatformString::Convert(reinterpret_cast<UTF8CHAR*>(Cursor), Length, *Value, Value.Len());
+            Cursor += Length;
+        }
+    }
+
+    FORCEINLINE void WriteString(FUtf8StringView Value)
+    {
+        WriteInt32(Value.Len());
+        WriteBytes(Value.GetData(), Value.Len());
+    }
+
+    template<typename T>
+    FORCEINLINE void WritePrimitiveArray(TArrayView<const T> Array)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "WritePrimitiveArray requires a trivially copyable element type");
+        static_assert(PLATFORM_LITTLE_ENDIAN, "BSATN is little-endian; WritePrimitiveArray copies elements as-is");
+
+        WriteInt32(Array.Num());
+        WriteBytes(Array.GetData(), static_cast<int64>(Array.Num()) * sizeof(T));
+    }
+
+    template<typename T, typename AllocatorType>
+    FORCEINLINE void WritePrimitiveArray(const TArray<T, AllocatorType>& Array)
+    {
+        WritePrimitiveArray<T>(TArrayView<const T>(Array));
+    }
+
+private:
+    uint8* Cursor;
+    uint8* End;
+};
@@ -1,6 +1,8 @@
 ﻿#pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/StringView.h"
+#include <type_traits>
 #include "FI128.h"
 #include "FI256.h"
 #include "FU128.h"
@@ -29,6 +31,12 @@ public:
     void Reset();
 
     void WriteBytes(const void* InData, int64 Count);
+
+    // Claims the next Count bytes in one go and returns them to be filled in, e.g. by an FBinarySpanWriter
+    TArrayView<uint8> WriteUninitialized(int64 Count);
+
+    // Overwrites an int32 already written at At, used to fill in a length prefix once the payload is known
+    void PatchInt32(int64 At, int32 Value);
     
     void WriteBool(bool Value);
     
@@ -63,6 +71,7 @@ public:
     void WriteOptionalDouble(const TOptional<double>& Value);
 
     void WriteString(const FString& Value);
+    void WriteString(FUtf8StringView Value);
     void WriteOptionalString(const TOptional<FString>& Value);
 
     void WriteI128(const FI128& Value);
@@ -82,8 +91,8 @@ public:
     void WriteConnectionId(const FStdbConnectionId& Value);
     void WriteIdentity(const FStdbIdentity& Value);
 
-    template<typename T>
-    void WriteArray(const TArray<T>& Array, TFunction<void(FBinaryWriter&, const T&)> ElementWriter)
+    template<typename T, typename AllocatorType>
+    void WriteArray(const TArray<T, AllocatorType>& Array, TFunction<void(FBinaryWriter&, const T&)> ElementWriter)
     {
         WriteInt32(Array.Num());
     
@@ -94,14 +103,37 @@ public:
     }
     
     void WriteStringArray(const TArray<FString>& Array);
+
+    // Bulk path for arrays of trivially copyable elements: one capacity check and one memcpy for the whole array
     template<typename T>
-    void WritePrimitiveArray(const TArray<T>& Array);
+    void WritePrimitiveArray(TArrayView<const T> Array)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "WritePrimitiveArray requires a trivially copyable element type");
+        static_assert(PLATFORM_LITTLE_ENDIAN, "BSATN is little-endian; WritePrimitiveArray copies elements as-is");
+
+        WriteInt32(Array.Num());
+        WriteBytes(Array.GetData(), static_cast<int64>(Array.Num()) * sizeof(T));
+    }
+
+    template<typename T, typename AllocatorType>
+    void WritePrimitiveArray(const TArray<T, AllocatorType>& Array)
+    {
+        WritePrimitiveArray<T>(TArrayView<const T>(Array));
+    }
 private:
     TArray<uint8>* Data;
     TArray<uint8> InternalData;
     bool bOwnsData;
     int64 Position;
     
-    void EnsureCapacity(int64 AdditionalBytes);
+    FORCEINLINE void EnsureCapacity(int64 AdditionalBytes)
+    {
+        if (Position + AdditionalBytes > Data->Num())
+        {
+            Grow(Position + AdditionalBytes);
+        }
+    }
+
+    void Grow(int64 NeededSize);
     
 };
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ClientApi/FBsatnRowView.h"
+
+/**
+ * FStdbBufferPool: Recycles the byte buffers inbound messages are received and decoded into.
+ * A buffer handed out by Acquire returns to the pool when its last reference is released,
+ * which for decoded messages is when the game thread is done with the FServerMessage.
+ */
+class SPACETIMEDB_API FStdbBufferPool : public TSharedFromThis<FStdbBufferPool, ESPMode::ThreadSafe>
+{
+public:
+	FStdbBufferPool(int32 InMaxPooledBuffers = 16, int64 InMaxPooledCapacity = 8 * 1024 * 1024);
+	~FStdbBufferPool();
+
+	/** Returns an empty buffer with at least MinCapacity bytes reserved */
+	FStdbSharedBuffer Acquire(int64 MinCapacity);
+
+private:
+	void Release(TArray<uint8>* Buffer);
+
+	// Buffers that grew past this are freed instead of pooled, so one huge subscription doesn't pin its memory
+	const int32 MaxPooledBuffers;
+	const int64 MaxPooledCapacity;
+
+	FCriticalSection Lock;
+	TArray<TArray<uint8>*> FreeBuffers;
+};
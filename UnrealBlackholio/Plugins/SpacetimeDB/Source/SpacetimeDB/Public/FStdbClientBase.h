@@ -5,11 +5,19 @@
 #include "StdbTypes.h"
 #include "WebSocketsModule.h"
 #include "ClientApi/FServerMessage.h"
+#include "ClientApi/FClientMessage.h"
+#include "FStdbBufferPool.h"
+#include "FStdbSender.h"
+#include "FStdbConnectionStats.h"
+#include "ClientCache/FStdbClientCache.h"
+#include "FStdbSubscriptionManager.h"
 #include "Misc/DateTime.h"
 #include "HAL/PlatformProcess.h"
+#include <atomic>
 
 
-struct FClientMessage;
+class FQueuedThreadPool;
+class FStdbDecodeWork;
 /**
  * FStdbClient: Owns the websocket worker and is a preprocessing thread.
  * Receives raw messages from the websocket worker, preprocesses (decompress/deserializes),
@@ -35,9 +43,36 @@ public:
 
 	void Connect();
 	void Shutdown();	
+	/** Applies decoded messages on the game thread, within the frame budget if one is set */
 	void FrameTick();
+
+	/** Overrides FStdbConnectOptions::FrameBudgetMs, 0 removes the budget. Game thread only. */
+	void SetFrameBudgetMs(float InFrameBudgetMs) { FrameBudgetSeconds = FMath::Max(InFrameBudgetMs, 0.0f) / 1000.0; }
 	
+	/** Subscribes to every table with a single legacy Subscribe */
 	void LegacySubscribe();
+
+	/**
+	 * Subscribes to the rows matching Queries as one query set, see FStdbSubscriptionManager.
+	 * Can be called before the connection is up, the request is sent once it is. Game thread only.
+	 */
+	FQueryId Subscribe(const TArray<FString>& Queries,
+	                   FStdbSubscriptionManager::FOnApplied OnApplied = FStdbSubscriptionManager::FOnApplied(),
+	                   FStdbSubscriptionManager::FOnError OnError = FStdbSubscriptionManager::FOnError())
+	{
+		return Subscriptions.Subscribe(Queries, MoveTemp(OnApplied), MoveTemp(OnError));
+	}
+
+	bool Unsubscribe(FQueryId QueryId, FStdbSubscriptionManager::FOnEnded OnEnded = FStdbSubscriptionManager::FOnEnded())
+	{
+		return Subscriptions.Unsubscribe(QueryId, MoveTemp(OnEnded));
+	}
+
+	/** Query sets subscribed with Subscribe and their state. Game thread only. */
+	const FStdbSubscriptionManager& GetSubscriptions() const { return Subscriptions; }
+
+	/** Subscribed table rows, register row types here before Connect. Game thread only. */
+	FStdbClientCache& GetClientCache() { return ClientCache; }
 	
 	DECLARE_DELEGATE_TwoParams(FOnConnect, FStdbIdentity /*Identity*/, FString /*Token*/);
 	DECLARE_DELEGATE_OneParam(FOnConnectError, const FString& /*Error*/);
@@ -46,12 +81,73 @@ public:
 	FOnConnect OnConnect;
 	FOnConnectError OnConnectError;
 	FOnDisconnect OnDisconnect;
+
+	DECLARE_DELEGATE_OneParam(FOnReducerResult, const FTransactionUpdateData& /*Update*/);
+
+	/**
+	 * Calls a reducer with arguments from a struct declaring its fields with STDB_BSATN_FIELDS,
+	 * the call is encoded in one pass at its exact size.
+	 * OnResult runs on the game thread with the TransactionUpdate answering this call.
+	 * Returns the request id of the call, or 0 if the outbound queue is full and the call
+	 * was dropped. Game thread only.
+	 */
+	template<typename TArgs>
+	uint32 CallReducer(const FString& Reducer, const TArgs& Args, FOnReducerResult OnResult = FOnReducerResult(),
+	                   ECallReducerFlags Flags = ECallReducerFlags::FullUpdate)
+	{
+		return SendReducerCall(Reducer, [&Reducer, &Args, Flags](uint32 RequestId, FBinaryWriter& Writer)
+		{
+			FClientMessage::SerializeCallReducerArgs(Reducer, Args, RequestId, static_cast<uint8>(Flags), Writer);
+		}, MoveTemp(OnResult), Flags);
+	}
+
+	/**
+	 * Calls a reducer whose arguments are written by WriteArgs straight into a pooled send buffer.
+	 * With NoSuccessNotify the server only answers failed calls, OnResult is not tracked then.
+	 */
+	uint32 CallReducerWith(const FString& Reducer, TFunctionRef<void(FBinaryWriter&)> WriteArgs,
+	                       FOnReducerResult OnResult = FOnReducerResult(),
+	                       ECallReducerFlags Flags = ECallReducerFlags::FullUpdate);
+
+	/**
+	 * Lets a call to Reducer replace an earlier call to it that hasn't been sent yet, for
+	 * reducers where only the latest state matters like per frame input. Calls with an
+	 * OnResult callback are never coalesced. Game thread only.
+	 */
+	void SetReducerCoalescing(const FString& Reducer, bool bCoalesce);
+
+	/** Snapshot of the connection's counters, any thread */
+	FStdbConnectionStats GetStats() const;
 	
 private:
-	void DecompressAndDeserialize(const TArray<uint8>& InBytes, const FDateTime& InTimestamp, FServerMessage& OutMessage);
-	void HandleProcessedMessage(const TSharedPtr<FServerMessage>& Msg);
+	/** False when the message carried data that couldn't be decoded, as opposed to carrying nothing */
+	bool DecompressAndDeserialize(const FStdbSharedBuffer& InBytes, const FDateTime& InTimestamp, FServerMessage& OutMessage) const;
+	struct FProcessedMessage
+	{
+		TSharedPtr<FServerMessage> Message;
+		// Rows of the message decoded into the registered table types, ready to apply
+		FStdbCacheDiff CacheDiff;
+		// The message was lost, the game thread has to stop applying updates
+		bool bDecodeFailed = false;
+		// Marks where the socket closed, everything before it was received on the closed connection
+		bool bConnectionClosed = false;
+		FString CloseReason;
+
+		bool IsEmpty() const { return !Message.IsValid() && !bDecodeFailed && !bConnectionClosed; }
+	};
+	void BuildCacheDiff(const FServerMessage& Msg, FStdbCacheDiff& OutDiff) const;
+	/** Encodes a call with a fresh request id into a pooled buffer and queues it */
+	uint32 SendReducerCall(const FString& Reducer, TFunctionRef<void(uint32 /*RequestId*/, FBinaryWriter&)> Encode,
+	                       FOnReducerResult OnResult, ECallReducerFlags Flags);
+	void HandleProcessedMessage(FProcessedMessage& Processed);
+	/** Asks the client thread to close the socket. Any thread. */
+	void RequestClose(const FString& Reason);
+	/** Drops the state tied to the connection: query sets, pending reducer calls and cached rows. Game thread only. */
+	void ResetConnectionState();
 
 	FStdbIdentity Identity;
+	FStdbConnectionId ConnectionId;
+	FStdbClientCache ClientCache;
 	const FStdbConnectOptions ConnectOptions;
 	const FString AuthToken;
 	const FString Host;
@@ -61,6 +157,11 @@ private:
 
 	FThreadSafeBool bIsConnected = false;
 	FThreadSafeBool bStartConnection = false;
+	FThreadSafeBool bCloseRequested = false;
+	FCriticalSection CloseReasonLock;
+	FString CloseReason;
+	// Set on the game thread once a message was lost, later updates would apply on top of a cache that drifted
+	bool bCacheOutOfSync = false;
 	bool bCallbacksInitialized = false;
 	FEvent* ConnectEvent = nullptr;
 	bool bConnectResult = false;
@@ -72,22 +173,87 @@ private:
 	
 	void HandleRawMessage(const void* Data, SIZE_T Size, SIZE_T BytesRemaining);
 	void HandleClosed(int32 StatusCode, const FString& Reason, bool bWasClean);
-	void SendClientMessage(const FClientMessage& ClientMessage) const;
+	bool EnqueueClientMessage(const FClientMessage& ClientMessage);
+	bool SendFrame(const TArray<uint8>& Frame) const;
 	
 	FThreadSafeBool bStop;
 	FRunnableThread* Thread;
 	FEvent* WakeEvent = nullptr;
+	// Triggered by the client thread whenever it takes a message out of RawMessageQueue
+	FEvent* RawQueueSpaceEvent = nullptr;
+	// Websocket thread only
+	double LastReceiveStallWarning = TNumericLimits<double>::Lowest();
 
 	struct FUnprocessedMessage {
-		TArray<uint8> Bytes;
+		// Pooled buffer the frame was received into, an uncompressed message is decoded from it in place
+		FStdbSharedBuffer Bytes;
 		FDateTime Timestamp;
+		// No bytes, tells the game thread the connection closed once it got to this point
+		bool bConnectionClosed = false;
+		FString CloseReason;
 		FUnprocessedMessage() = default;
-		FUnprocessedMessage(const TArray<uint8>& InBytes, const FDateTime& InTimestamp)
+		FUnprocessedMessage(const FStdbSharedBuffer& InBytes, const FDateTime& InTimestamp)
 			: Bytes(InBytes), Timestamp(InTimestamp) {}
 	};
-	FThreadSafeQueue<FUnprocessedMessage> RawMessageQueue;
-	FThreadSafeQueue<TSharedPtr<FServerMessage>> ProcessedMessageQueue;
-	FThreadSafeQueue<FClientMessage> ClientMessageQueue;
+	/** Queues a message for the client thread, waits while the queue is full. Websocket thread only. */
+	void EnqueueRawMessage(FUnprocessedMessage& Message);
+	TSharedPtr<FStdbBufferPool, ESPMode::ThreadSafe> BufferPool;
+	// Message being reassembled from websocket fragments, only touched on the websocket thread
+	FUnprocessedMessage PartialMessage;
+	// Websocket thread -> client thread
+	TStdbSpscRing<FUnprocessedMessage> RawMessageQueue;
+	// Sequencer (decode workers, serialized by SequencerLock) -> game thread
+	TStdbSpscRing<FProcessedMessage> ProcessedMessageQueue;
+	// Client messages are encoded into pooled buffers on the calling thread and sent in order by the sender thread
+	TUniquePtr<FStdbSender> Sender;
+	TSet<FName> CoalescedReducers;
+	// Game thread only
+	FStdbSubscriptionManager Subscriptions;
+
+	mutable FCriticalSection StatsLock;
+	FStdbConnectionStats Stats;
+
+	double FrameBudgetSeconds = 0.0;
+
+	// Reducer calls waiting for their TransactionUpdate, keyed by request id. Game thread only.
+	uint32 NextRequestId = 1;
+	TMap<uint32, FOnReducerResult> PendingReducerCalls;
+
+	/**
+	 * Decode workers: raw messages are numbered in arrival order and decoded in parallel,
+	 * the sequencer then releases them to ProcessedMessageQueue in that same order.
+	 * A message counts as in flight from the moment it leaves RawMessageQueue until it is released,
+	 * the client thread stops taking messages at MaxDecodesInFlight.
+	 */
+	friend class FStdbDecodeWork;
+	void DecodeMessage(uint64 Sequence, const FUnprocessedMessage& Raw);
+	void ReleaseInOrder(uint64 Sequence, FProcessedMessage&& Processed);
+	// Moves contiguous decoded messages into ProcessedMessageQueue until it is full, SequencerLock must be held
+	void ReleasePendingLocked();
+	// Null when every work item is still out on the pool
+	FStdbDecodeWork* AcquireDecodeWork();
+	void ReturnDecodeWork(FStdbDecodeWork* Work);
+
+	FQueuedThreadPool* DecodePool = nullptr;
+	int32 MaxDecodesInFlight = 0;
+	std::atomic<int32> NumDecodesInFlight{0};
+	// Client thread only
+	uint64 NextDecodeSequence = 0;
+
+	TArray<TUniquePtr<FStdbDecodeWork>> DecodeWork;
+	FCriticalSection DecodeWorkLock;
+	TArray<FStdbDecodeWork*> FreeDecodeWork;
+
+	struct FPendingRelease
+	{
+		FProcessedMessage Processed;
+		bool bDecoded = false;
+	};
+	FCriticalSection SequencerLock;
+	uint64 NextReleaseSequence = 0;
+	// Decoded messages waiting for their turn, indexed by sequence modulo MaxDecodesInFlight
+	TArray<FPendingRelease> PendingRelease;
+	int32 NumPendingRelease = 0;
 	
 	static inline FString CompressionToString(EStdbCompression Compression)
 	{
@@ -95,9 +261,10 @@ private:
 		{
 		case EStdbCompression::None:
 			return TEXT("None");
+		case EStdbCompression::Brotli:
+			return TEXT("Brotli");
 		case EStdbCompression::Gzip:
 			return TEXT("Gzip");
-		// Add Brotli
 		default:
 			return TEXT("None");
 		}
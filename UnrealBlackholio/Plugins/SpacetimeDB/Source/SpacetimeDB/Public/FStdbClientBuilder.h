@@ -20,6 +20,10 @@ public:
 	FStdbClientBuilder& WithToken(const FString& InToken);
 	FStdbClientBuilder& WithCompression(EStdbCompression InCompression);
 	FStdbClientBuilder& WithLight(bool bInLight);
+	FStdbClientBuilder& WithDecodeWorkers(int32 InDecodeWorkers);
+	FStdbClientBuilder& WithFrameBudget(float InFrameBudgetMs);
+	// Registers the cached tables, runs before the client connects
+	FStdbClientBuilder& WithTables(TFunction<void(FStdbClientCache&)> InRegisterTables);
 
 	// Chainable callback methods
 	FStdbClientBuilder& OnConnect(TFunction<void(FStdbIdentity /*Identity*/, FString /*Token*/)> InOnConnect);
@@ -35,7 +39,11 @@ private:
 	FString Token;
 	EStdbCompression Compression = EStdbCompression::None;
 	bool bLight = false;
+	int32 DecodeWorkers = 0;
+	float FrameBudgetMs = 0.0f;
 	
+	TFunction<void(FStdbClientCache&)> RegisterTablesCb;
+
 	TFunction<void(FStdbIdentity, FString)> OnConnectCb;
 	TFunction<void(const FString&)> OnConnectErrorCb;
 	TFunction<void(const FString&)> OnDisconnectCb;
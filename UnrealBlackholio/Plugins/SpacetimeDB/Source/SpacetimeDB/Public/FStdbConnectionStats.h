@@ -0,0 +1,29 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TStdbSpscRing.h"
+
+/**
+ * FStdbConnectionStats: Counters for one connection, read with FStdbClientBase::GetStats.
+ */
+struct SPACETIMEDB_API FStdbConnectionStats
+{
+	// Received messages waiting to be decoded, decoded messages waiting for the game thread,
+	// and encoded client messages waiting to be sent
+	FStdbQueueStats RawMessageQueue;
+	FStdbQueueStats ProcessedMessageQueue;
+	FStdbQueueStats OutboundMessageQueue;
+
+	// Times the websocket thread had to wait for room in the received queue, and for how long in total
+	uint64 ReceiveStalls = 0;
+	double ReceiveStallSeconds = 0.0;
+
+	// Game thread dispatch in FrameTick
+	int32 LastFrameMessagesApplied = 0;
+	// Left for the next frame, both queued for the game thread and held back in the sequencer
+	int32 LastFrameMessagesDeferred = 0;
+	double LastFrameDispatchSeconds = 0.0;
+	double MaxFrameDispatchSeconds = 0.0;
+	// Frames that ran out of budget with messages still queued
+	uint64 FramesOverBudget = 0;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StdbTypes.h"
+
+/**
+ * FStdbDecompressor: Streaming Gzip/Brotli decoding for server messages and compressed query updates.
+ * The output buffer grows as the stream produces data, so no uncompressed size is needed up front.
+ */
+class SPACETIMEDB_API FStdbDecompressor
+{
+public:
+	// Upper bound for a single decompressed payload, protects against decompression bombs
+	static constexpr int64 MaxDecompressedSize = 0x40000000; // 1GB
+
+	/** Appends the decompressed contents of InData to OutData, returns false on corrupt or truncated input */
+	static bool Decompress(EStdbCompression Algo, TArrayView<const uint8> InData, TArray<uint8>& OutData);
+
+	static bool IsSupported(EStdbCompression Algo);
+
+private:
+	static bool InflateGzip(TArrayView<const uint8> InData, TArray<uint8>& OutData);
+	static bool DecompressBrotli(TArrayView<const uint8> InData, TArray<uint8>& OutData);
+
+	/** Makes room for more output, doubling what has been produced so far */
+	static bool GrowOutput(TArray<uint8>& OutData, int64 Written, int64 InputSize);
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ContainerAllocationPolicies.h"
+
+/**
+ * FStdbMessageArena: Linear allocator scoped to one decoded server message.
+ * Allocations bump a cursor through large blocks and are never freed one by one,
+ * the whole arena goes away with the message that owns it.
+ * Arrays using FStdbArenaAllocator allocate from the arena made current with FStdbArenaScope
+ * on the thread that constructs them. A single arena is only used by one thread at a time,
+ * threads helping to decode the same message each get a child arena.
+ */
+class SPACETIMEDB_API FStdbMessageArena
+{
+public:
+	explicit FStdbMessageArena(int64 InBlockSize = 64 * 1024);
+	~FStdbMessageArena();
+
+	FStdbMessageArena(const FStdbMessageArena&) = delete;
+	FStdbMessageArena& operator=(const FStdbMessageArena&) = delete;
+
+	void* Allocate(SIZE_T Size, uint32 Alignment);
+
+	/** Grows Ptr from OldSize to NewSize without moving it, only possible for the latest allocation */
+	bool TryGrowInPlace(void* Ptr, SIZE_T OldSize, SIZE_T NewSize);
+
+	/** Arena for another thread decoding into the same message, lives as long as this one. Any thread. */
+	FStdbMessageArena& CreateChild();
+
+	/** Bytes handed out by this arena and its children */
+	SIZE_T GetBytesUsed() const;
+
+	/** Arena of the innermost FStdbArenaScope on this thread, or null */
+	static FStdbMessageArena* GetCurrent();
+
+private:
+	friend class FStdbArenaScope;
+	static void SetCurrent(FStdbMessageArena* Arena);
+
+	void AddBlock(SIZE_T MinSize);
+
+	const int64 BlockSize;
+	TArray<uint8*, TInlineAllocator<4>> Blocks;
+	uint8* Cursor = nullptr;
+	uint8* End = nullptr;
+	SIZE_T BytesUsed = 0;
+
+	mutable FCriticalSection ChildLock;
+	TArray<TUniquePtr<FStdbMessageArena>> Children;
+};
+
+/**
+ * FStdbArenaScope: Makes an arena current on this thread for its lifetime, nests.
+ */
+class SPACETIMEDB_API FStdbArenaScope
+{
+public:
+	explicit FStdbArenaScope(FStdbMessageArena* Arena);
+	~FStdbArenaScope();
+
+	FStdbArenaScope(const FStdbArenaScope&) = delete;
+	FStdbArenaScope& operator=(const FStdbArenaScope&) = delete;
+
+private:
+	FStdbMessageArena* Previous;
+};
+
+/**
+ * FStdbArenaAllocator: TArray allocator that takes its memory from the arena current when
+ * the array was constructed, or from the heap when there was none. Arena memory is released
+ * with the arena, so an arena backed array must not outlive the message it was decoded into.
+ */
+class SPACETIMEDB_API FStdbArenaAllocator
+{
+public:
+	using SizeType = int32;
+
+	enum { NeedsElementType = false };
+	enum { RequireRangeCheck = true };
+
+	class SPACETIMEDB_API ForAnyElementType
+	{
+	public:
+		ForAnyElementType()
+			: Data(nullptr)
+			, Arena(FStdbMessageArena::GetCurrent())
+			, AllocatedBytes(0)
+		{
+		}
+
+		ForAnyElementType(const ForAnyElementType&) = delete;
+		ForAnyElementType& operator=(const ForAnyElementType&) = delete;
+
+		~ForAnyElementType()
+		{
+			if (Data && !Arena)
+			{
+				FMemory::Free(Data);
+			}
+		}
+
+		void MoveToEmpty(ForAnyElementType& Other);
+
+		FScriptContainerElement* GetAllocation() const { return Data; }
+
+		void ResizeAllocation(SizeType CurrentNum, SizeType NewMax, SIZE_T NumBytesPerElement)
+		{
+			ResizeAllocation(CurrentNum, NewMax, NumBytesPerElement, DEFAULT_ALIGNMENT);
+		}
+
+		void ResizeAllocation(SizeType CurrentNum, SizeType NewMax, SIZE_T NumBytesPerElement, uint32 AlignmentOfElement);
+
+		SizeType CalculateSlackReserve(SizeType NewMax, SIZE_T NumBytesPerElement) const
+		{
+			return DefaultCalculateSlackReserve(NewMax, NumBytesPerElement, !Arena);
+		}
+
+		SizeType CalculateSlackReserve(SizeType NewMax, SIZE_T NumBytesPerElement, uint32 AlignmentOfElement) const
+		{
+			return DefaultCalculateSlackReserve(NewMax, NumBytesPerElement, !Arena, AlignmentOfElement);
+		}
+
+		// Arena memory can't be handed back early, shrinking would only copy
+		SizeType CalculateSlackShrink(SizeType NewMax, SizeType CurrentMax, SIZE_T NumBytesPerElement) const
+		{
+			return Arena ? CurrentMax : DefaultCalculateSlackShrink(NewMax, CurrentMax, NumBytesPerElement, true);
+		}
+
+		SizeType CalculateSlackShrink(SizeType NewMax, SizeType CurrentMax, SIZE_T NumBytesPerElement, uint32 AlignmentOfElement) const
+		{
+			return Arena ? CurrentMax : DefaultCalculateSlackShrink(NewMax, CurrentMax, NumBytesPerElement, true, AlignmentOfElement);
+		}
+
+		SizeType CalculateSlackGrow(SizeType NewMax, SizeType CurrentMax, SIZE_T NumBytesPerElement) const
+		{
+			return DefaultCalculateSlackGrow(NewMax, CurrentMax, NumBytesPerElement, !Arena);
+		}
+
+		SizeType CalculateSlackGrow(SizeType NewMax, SizeType CurrentMax, SIZE_T NumBytesPerElement, uint32 AlignmentOfElement) const
+		{
+			return DefaultCalculateSlackGrow(NewMax, CurrentMax, NumBytesPerElement, !Arena, AlignmentOfElement);
+		}
+
+		SIZE_T GetAllocatedSize(SizeType CurrentMax, SIZE_T NumBytesPerElement) const
+		{
+			return CurrentMax * NumBytesPerElement;
+		}
+
+		bool HasAllocation() const { return !!Data; }
+
+		SizeType GetInitialCapacity() const { return 0; }
+
+	private:
+		FScriptContainerElement* Data;
+		FStdbMessageArena* Arena;
+		SIZE_T AllocatedBytes;
+	};
+
+	template<typename ElementType>
+	class ForElementType : public ForAnyElementType
+	{
+	public:
+		ForElementType()
+		{
+		}
+
+		ElementType* GetAllocation() const
+		{
+			return reinterpret_cast<ElementType*>(ForAnyElementType::GetAllocation());
+		}
+	};
+};
+
+template<>
+struct TAllocatorTraits<FStdbArenaAllocator> : TAllocatorTraitsBase<FStdbArenaAllocator>
+{
+	enum { SupportsMove = true };
+	enum { SupportsElementAlignment = true };
+};
+
+template<typename T>
+using TStdbArenaArray = TArray<T, FStdbArenaAllocator>;
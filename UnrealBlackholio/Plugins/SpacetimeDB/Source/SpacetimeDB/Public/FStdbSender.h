@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "TStdbSpscRing.h"
+#include "ClientApi/FBsatnRowView.h"
+
+class FEvent;
+class FRunnableThread;
+
+/**
+ * FStdbSender: Owns the thread that puts encoded client messages on the websocket.
+ * It wakes as soon as a frame is enqueued, takes everything queued since its last pass
+ * as one batch, up to the queue capacity, and sends it in order. Frames enqueued with a
+ * coalesce key replace an earlier frame with the same key that is still waiting in the batch.
+ */
+class SPACETIMEDB_API FStdbSender : public FRunnable
+{
+public:
+	// Sends one frame, returns false when the connection can't take it yet
+	using FSendFrame = TFunction<bool(const TArray<uint8>& /*Frame*/)>;
+
+	FStdbSender(FSendFrame InSendFrame, uint32 InQueueCapacity);
+	virtual ~FStdbSender();
+
+	void Start(const FString& ThreadName);
+	void Shutdown();
+
+	/** Producer thread only, returns false without taking the frame when the queue is full */
+	bool TryEnqueue(FStdbSharedBuffer& Frame, FName CoalesceKey = NAME_None);
+
+	FStdbQueueStats GetQueueStats() const { return OutboundQueue.GetStats(); }
+
+	/** Retries a batch that is waiting for the connection */
+	void Wake();
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	struct FOutboundFrame
+	{
+		FStdbSharedBuffer Bytes;
+		FName CoalesceKey;
+
+		FOutboundFrame() = default;
+		FOutboundFrame(FStdbSharedBuffer&& InBytes, FName InCoalesceKey)
+			: Bytes(MoveTemp(InBytes)), CoalesceKey(InCoalesceKey) {}
+	};
+
+	void DrainIntoBatch();
+	bool SendBatch();
+
+	const FSendFrame SendFrame;
+
+	TStdbSpscRing<FOutboundFrame> OutboundQueue;
+	FThreadSafeBool bStop;
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeEvent = nullptr;
+
+	// Only touched on the sender thread, reserved for the queue capacity and kept across batches so they don't reallocate
+	TArray<FOutboundFrame> Batch;
+	int32 NumSent = 0;
+	TMap<FName, int32> CoalesceSlots;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ClientApi/FClientMessage.h"
+#include "ClientApi/FServerMessage.h"
+
+enum class EStdbSubscriptionState : uint8
+{
+	// Not subscribed, or the query id was never handed out
+	None,
+	// SubscribeMulti sent, waiting for SubscribeMultiApplied
+	Pending,
+	Applied,
+	// UnsubscribeMulti sent or about to be, waiting for UnsubscribeMultiApplied
+	Unsubscribing,
+	Error
+};
+
+/**
+ * FStdbSubscriptionManager: Query sets subscribed with SubscribeMulti, each under its own FQueryId.
+ * Tracks every set from the request until the server confirms or rejects it, and until it is
+ * unsubscribed again. Rows the sets share are reference counted by the table caches, so
+ * unsubscribing one set leaves rows another set still matches in place.
+ * Game thread only.
+ */
+class SPACETIMEDB_API FStdbSubscriptionManager
+{
+public:
+	// Queues a client message, returns false when it couldn't be queued
+	using FSendMessage = TFunction<bool(const FClientMessage& /*Message*/)>;
+
+	DECLARE_DELEGATE_OneParam(FOnApplied, FQueryId /*QueryId*/);
+	DECLARE_DELEGATE_TwoParams(FOnError, FQueryId /*QueryId*/, const FString& /*Error*/);
+	DECLARE_DELEGATE_OneParam(FOnEnded, FQueryId /*QueryId*/);
+
+	explicit FStdbSubscriptionManager(FSendMessage InSendMessage);
+
+	/**
+	 * Subscribes to the rows matching Queries. OnApplied runs once their rows are in the cache,
+	 * OnError if the server rejects the queries or drops them later on.
+	 * Returns the id of the query set, or an id of 0 if the outbound queue is full.
+	 */
+	FQueryId Subscribe(const TArray<FString>& Queries, FOnApplied OnApplied = FOnApplied(), FOnError OnError = FOnError());
+
+	/**
+	 * Removes a query set, OnEnded runs once the rows only it matched are gone from the cache.
+	 * A set that is still pending is unsubscribed as soon as it is applied, one that failed
+	 * is forgotten right away since the server already dropped it.
+	 */
+	bool Unsubscribe(FQueryId QueryId, FOnEnded OnEnded = FOnEnded());
+
+	EStdbSubscriptionState GetState(FQueryId QueryId) const;
+
+	/** Queries of a set that hasn't ended yet, null otherwise */
+	const TArray<FString>* GetQueries(FQueryId QueryId) const;
+
+	/** Why the server rejected or dropped a set in the Error state */
+	FString GetError(FQueryId QueryId) const;
+
+	int32 Num() const { return Subscriptions.Num(); }
+
+	// Server messages, after their rows were applied to the cache
+	void HandleSubscribeMultiApplied(const FSubscribeMultiAppliedData& Data);
+	void HandleUnsubscribeMultiApplied(const FUnsubscribeMultiAppliedData& Data);
+	void HandleSubscriptionError(const FSubscriptionErrorData& Data);
+
+	/** Forgets every query set, for a connection that went away. No callbacks run. */
+	void Reset();
+
+	/** Request id for a client message sent outside the manager, so its answer can't be taken for one of ours */
+	uint32 AllocateRequestId() { return NextRequestId++; }
+
+private:
+	struct FSubscription
+	{
+		TArray<FString> Queries;
+		uint32 RequestId = 0;
+		EStdbSubscriptionState State = EStdbSubscriptionState::Pending;
+		FString Error;
+		// Set by Unsubscribe while the set is pending
+		bool bUnsubscribeWhenApplied = false;
+		FOnApplied OnApplied;
+		FOnError OnError;
+		FOnEnded OnEnded;
+	};
+
+	bool SendUnsubscribe(FQueryId QueryId);
+	void FailSubscription(uint32 QueryId, const FString& Error);
+
+	FSendMessage SendMessage;
+
+	// Query ids are per connection and never reused on it, 0 stays free to mean none.
+	// Request ids keep counting across Reset, answers to the old connection's requests may still be queued
+	uint32 NextQueryId = 1;
+	uint32 NextRequestId = 1;
+	TMap<uint32, FSubscription> Subscriptions;
+	// Pending sets by the request id of their SubscribeMulti, for errors that only carry the request id
+	TMap<uint32, uint32> QueryIdByRequestId;
+};
@@ -1,7 +1,6 @@
 ﻿#pragma once
 
 #include "CoreMinimal.h"
-#include "Containers/Queue.h"
 #include "Templates/SharedPointer.h"
 #include "StdbTypes.generated.h"
 
@@ -11,16 +10,28 @@ struct SPACETIMEDB_API FStdbConnectOptions
 	GENERATED_BODY()
 	UPROPERTY()
 	FString Protocol;
+
+	// Number of threads decoding inbound messages for this connection. 0 uses one per core but one,
+	// which is left to the game thread, and at least one. Set through FStdbClientBuilder::WithDecodeWorkers
+	UPROPERTY()
+	int32 DecodeWorkers = 0;
+
+	// Slots in each of the connection's message queues (received, decoded and outbound), rounded up to a power of two
+	UPROPERTY()
+	int32 MessageQueueCapacity = 1024;
+
+	// Game thread time FrameTick may spend applying messages per frame, the rest waits for the next frame.
+	// At least one message is applied per frame. 0 applies everything that is queued
+	UPROPERTY()
+	float FrameBudgetMs = 0.0f;
 };
 
+// Values match the compression tag SpacetimeDB puts in front of every server message
 UENUM()
 enum class EStdbCompression : uint8
 {
 	None,
+	Brotli,
 	Gzip,
-	// Brotli unsupported
 };
 
-// Thread-safe queue alias (Unreal's TQueue is thread-safe in MPSC mode)
-template<typename T>
-using FThreadSafeQueue = TQueue<T, EQueueMode::Mpsc>;
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <type_traits>
+#include "FBinaryReader.h"
+#include "FBinaryWriter.h"
+#include "FStdbConnectionId.h"
+#include "FStdbIdentity.h"
+#include "FTimeDuration.h"
+#include "FTimestamp.h"
+
+/**
+ * TStdbBsatn: BSATN codec for one type: Read, Write and the exact encoded Size.
+ * Built-in types are specialized below. Structs list their fields once with STDB_BSATN_FIELDS,
+ * the primary template then expands the codec field by field at compile time, so readers,
+ * writers and sizes can't drift apart and nothing goes through a TFunction per field.
+ */
+template<typename T>
+struct TStdbBsatn
+{
+	static void Read(FBinaryReader& Reader, T& Value)
+	{
+		Value.VisitBsatnFields([&Reader](auto&... Fields)
+		{
+			(TStdbBsatn<std::decay_t<decltype(Fields)>>::Read(Reader, Fields), ...);
+		});
+	}
+
+	template<typename TWriter>
+	static void Write(TWriter& Writer, const T& Value)
+	{
+		Value.VisitBsatnFields([&Writer](const auto&... Fields)
+		{
+			(TStdbBsatn<std::decay_t<decltype(Fields)>>::Write(Writer, Fields), ...);
+		});
+	}
+
+	static int64 Size(const T& Value)
+	{
+		return Value.VisitBsatnFields([](const auto&... Fields)
+		{
+			return (static_cast<int64>(0) + ... + TStdbBsatn<std::decay_t<decltype(Fields)>>::Size(Fields));
+		});
+	}
+};
+
+struct FBsatnRowList;
+
+/**
+ * TStdbFixedRowDecoder: Bulk decoder FBsatnRowList::DecodeRows uses for FixedSize lists of TRow.
+ * A specialization sets bEnabled and has a static bool Decode(const FBsatnRowList&, TArray<TRow>&)
+ * that appends every row, or returns false without appending so the list is decoded row by row.
+ */
+template<typename TRow>
+struct TStdbFixedRowDecoder
+{
+	static constexpr bool bEnabled = false;
+};
+
+namespace StdbBsatn
+{
+	template<typename T>
+	FORCEINLINE void Read(FBinaryReader& Reader, T& Value)
+	{
+		TStdbBsatn<T>::Read(Reader, Value);
+	}
+
+	/** TWriter is FBinaryWriter, or FBinarySpanWriter when the size was computed up front */
+	template<typename TWriter, typename T>
+	FORCEINLINE void Write(TWriter& Writer, const T& Value)
+	{
+		TStdbBsatn<T>::Write(Writer, Value);
+	}
+
+	template<typename T>
+	FORCEINLINE int64 Size(const T& Value)
+	{
+		return TStdbBsatn<T>::Size(Value);
+	}
+}
+
+/**
+ * Declares the BSATN fields of a struct in wire order and gives it ReadFields, WriteFields
+ * and GetEncodedSize. Every field type needs a TStdbBsatn, either built in or its own STDB_BSATN_FIELDS.
+ */
+#define STDB_BSATN_FIELDS(...) \
+	template<typename TVisitor> \
+	FORCEINLINE decltype(auto) VisitBsatnFields(TVisitor&& Visitor) { return Visitor(__VA_ARGS__); } \
+	template<typename TVisitor> \
+	FORCEINLINE decltype(auto) VisitBsatnFields(TVisitor&& Visitor) const { return Visitor(__VA_ARGS__); } \
+	void ReadFields(FBinaryReader& Reader) { StdbBsatn::Read(Reader, *this); } \
+	void WriteFields(FBinaryWriter& Writer) const { StdbBsatn::Write(Writer, *this); } \
+	int64 GetEncodedSize() const { return StdbBsatn::Size(*this); }
+
+#define STDB_BSATN_FIXED(Type, ReadFunc, WriteFunc, NumBytes) \
+	template<> \
+	struct TStdbBsatn<Type> \
+	{ \
+		static FORCEINLINE void Read(FBinaryReader& Reader, Type& Value) { Value = Reader.ReadFunc(); } \
+		template<typename TWriter> \
+		static FORCEINLINE void Write(TWriter& Writer, const Type& Value) { Writer.WriteFunc(Value); } \
+		static constexpr int64 Size(const Type&) { return NumBytes; } \
+	};
+
+STDB_BSATN_FIXED(bool, ReadBool, WriteBool, 1)
+STDB_BSATN_FIXED(uint8, ReadByte, WriteByte, 1)
+STDB_BSATN_FIXED(int8, ReadSByte, WriteSByte, 1)
+STDB_BSATN_FIXED(int16, ReadInt16, WriteInt16, 2)
+STDB_BSATN_FIXED(uint16, ReadUInt16, WriteUInt16, 2)
+STDB_BSATN_FIXED(int32, ReadInt32, WriteInt32, 4)
+STDB_BSATN_FIXED(uint32, ReadUInt32, WriteUInt32, 4)
+STDB_BSATN_FIXED(int64, ReadInt64, WriteInt64, 8)
+STDB_BSATN_FIXED(uint64, ReadUInt64, WriteUInt64, 8)
+STDB_BSATN_FIXED(float, ReadFloat, WriteFloat, 4)
+STDB_BSATN_FIXED(double, ReadDouble, WriteDouble, 8)
+STDB_BSATN_FIXED(FI128, ReadI128, WriteI128, 16)
+STDB_BSATN_FIXED(FU128, ReadU128, WriteU128, 16)
+STDB_BSATN_FIXED(FI256, ReadI256, WriteI256, 32)
+STDB_BSATN_FIXED(FU256, ReadU256, WriteU256, 32)
+STDB_BSATN_FIXED(FTimeDuration, ReadTimeDuration, WriteTimeDuration, 8)
+STDB_BSATN_FIXED(FTimestamp, ReadTimestamp, WriteTimestamp, 8)
+STDB_BSATN_FIXED(FStdbConnectionId, ReadConnectionId, WriteConnectionId, 16)
+STDB_BSATN_FIXED(FStdbIdentity, ReadIdentity, WriteIdentity, 32)
+
+#undef STDB_BSATN_FIXED
+
+template<>
+struct TStdbBsatn<FString>
+{
+	static FORCEINLINE void Read(FBinaryReader& Reader, FString& Value) { Value = Reader.ReadString(); }
+	template<typename TWriter>
+	static FORCEINLINE void Write(TWriter& Writer, const FString& Value) { Writer.WriteString(Value); }
+
+	static int64 Size(const FString& Value)
+	{
+		return sizeof(int32) + FPlatformString::ConvertedLength<UTF8CHAR>(*Value, Value.Len());
+	}
+};
+
+/** Arrays of arithmetic types go through the bulk memcpy paths of the reader and writer */
+template<typename T, typename AllocatorType>
+struct TStdbBsatn<TArray<T, AllocatorType>>
+{
+	static void Read(FBinaryReader& Reader, TArray<T, AllocatorType>& Value)
+	{
+		if constexpr (std::is_arithmetic_v<T>)
+		{
+			Reader.ReadPrimitiveArray(Value);
+		}
+		else
+		{
+			const int32 Num = FMath::Max(Reader.ReadInt32(), 0);
+			Value.Reset(Num);
+			for (int32 i = 0; i < Num; ++i)
+			{
+				TStdbBsatn<T>::Read(Reader, Value.AddDefaulted_GetRef());
+			}
+		}
+	}
+
+	template<typename TWriter>
+	static void Write(TWriter& Writer, const TArray<T, AllocatorType>& Value)
+	{
+		if constexpr (std::is_arithmetic_v<T>)
+		{
+			Writer.WritePrimitiveArray(Value);
+		}
+		else
+		{
+			Writer.WriteInt32(Value.Num());
+			for (const T& Item : Value)
+			{
+				TStdbBsatn<T>::Write(Writer, Item);
+			}
+		}
+	}
+
+	static int64 Size(const TArray<T, AllocatorType>& Value)
+	{
+		if constexpr (std::is_arithmetic_v<T>)
+		{
+			return sizeof(int32) + static_cast<int64>(Value.Num()) * sizeof(T);
+		}
+		else
+		{
+			int64 Total = sizeof(int32);
+			for (const T& Item : Value)
+			{
+				Total += TStdbBsatn<T>::Size(Item);
+			}
+			return Total;
+		}
+	}
+};
+
+/** Same presence flag as FBinaryReader::ReadOptionalString and friends */
+template<typename T>
+struct TStdbBsatn<TOptional<T>>
+{
+	static void Read(FBinaryReader& Reader, TOptional<T>& Value)
+	{
+		Value.Reset();
+		if (Reader.ReadBool())
+		{
+			TStdbBsatn<T>::Read(Reader, Value.Emplace());
+		}
+	}
+
+	template<typename TWriter>
+	static void Write(TWriter& Writer, const TOptional<T>& Value)
+	{
+		Writer.WriteBool(Value.IsSet());
+		if (Value.IsSet())
+		{
+			TStdbBsatn<T>::Write(Writer, Value.GetValue());
+		}
+	}
+
+	static int64 Size(const TOptional<T>& Value)
+	{
+		return 1 + (Value.IsSet() ? TStdbBsatn<T>::Size(Value.GetValue()) : 0);
+	}
+};
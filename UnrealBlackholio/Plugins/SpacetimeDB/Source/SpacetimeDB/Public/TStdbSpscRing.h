@@ -0,0 +1,122 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ * Occupancy counters of a TStdbSpscRing
+ */
+struct FStdbQueueStats
+{
+	int32 Num = 0;
+	int32 Capacity = 0;
+	// Highest occupancy seen since the ring was created
+	int32 HighWaterMark = 0;
+	// Enqueues rejected because the ring was full
+	uint64 NumFull = 0;
+};
+
+/**
+ * TStdbSpscRing: Bounded lock-free queue for exactly one producer and one consumer thread.
+ * Slots are allocated once up front, so enqueueing never allocates. TryEnqueue returns false
+ * when the ring is full and leaves the item untouched, the producer decides how to back off.
+ * Several producer threads are fine as long as they are serialized by a lock of their own.
+ */
+template<typename T>
+class TStdbSpscRing
+{
+public:
+	/** Capacity is rounded up to a power of two */
+	explicit TStdbSpscRing(uint32 InCapacity)
+		: Capacity(FMath::RoundUpToPowerOfTwo(FMath::Max<uint32>(InCapacity, 2)))
+		  , Mask(Capacity - 1)
+		  , Slots(MakeUnique<TTypeCompatibleBytes<T>[]>(Capacity))
+	{
+	}
+
+	~TStdbSpscRing()
+	{
+		const uint32 Head = HeadIndex.load(std::memory_order_acquire);
+		for (uint32 Tail = TailIndex.load(std::memory_order_relaxed); Tail != Head; ++Tail)
+		{
+			DestructItem(Slots[Tail & Mask].GetTypedPtr());
+		}
+	}
+
+	TStdbSpscRing(const TStdbSpscRing&) = delete;
+	TStdbSpscRing& operator=(const TStdbSpscRing&) = delete;
+
+	/** Producer thread only, constructs the item in place from Args only if there is room */
+	template<typename... ArgTypes>
+	bool TryEnqueue(ArgTypes&&... Args)
+	{
+		const uint32 Head = HeadIndex.load(std::memory_order_relaxed);
+		const uint32 Count = Head - TailIndex.load(std::memory_order_acquire);
+		if (Count >= Capacity)
+		{
+			NumFull.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		new(Slots[Head & Mask].GetTypedPtr()) T(Forward<ArgTypes>(Args)...);
+		HeadIndex.store(Head + 1, std::memory_order_release);
+
+		if (Count + 1 > HighWaterMark.load(std::memory_order_relaxed))
+		{
+			HighWaterMark.store(Count + 1, std::memory_order_relaxed);
+		}
+		return true;
+	}
+
+	/** Consumer thread only */
+	bool Dequeue(T& OutItem)
+	{
+		const uint32 Tail = TailIndex.load(std::memory_order_relaxed);
+		if (Tail == HeadIndex.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		T* Item = Slots[Tail & Mask].GetTypedPtr();
+		OutItem = MoveTemp(*Item);
+		DestructItem(Item);
+		TailIndex.store(Tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Consumer thread only */
+	bool IsEmpty() const
+	{
+		return TailIndex.load(std::memory_order_relaxed) == HeadIndex.load(std::memory_order_acquire);
+	}
+
+	/** Any thread, may be stale by the time it returns */
+	int32 Num() const
+	{
+		return static_cast<int32>(HeadIndex.load(std::memory_order_acquire) - TailIndex.load(std::memory_order_acquire));
+	}
+
+	int32 GetCapacity() const { return static_cast<int32>(Capacity); }
+
+	FStdbQueueStats GetStats() const
+	{
+		FStdbQueueStats Stats;
+		Stats.Num = Num();
+		Stats.Capacity = GetCapacity();
+		Stats.HighWaterMark = static_cast<int32>(HighWaterMark.load(std::memory_order_relaxed));
+		Stats.NumFull = NumFull.load(std::memory_order_relaxed);
+		return Stats;
+	}
+
+private:
+	const uint32 Capacity;
+	const uint32 Mask;
+	TUniquePtr<TTypeCompatibleBytes<T>[]> Slots;
+
+	// Written by the producer and consumer respectively, kept on separate cache lines
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> HeadIndex{0};
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> TailIndex{0};
+
+	std::atomic<uint32> HighWaterMark{0};
+	std::atomic<uint64> NumFull{0};
+};
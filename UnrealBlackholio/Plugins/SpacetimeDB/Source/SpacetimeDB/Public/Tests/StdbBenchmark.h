@@ -0,0 +1,108 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Benchmarks only run from the Perf filter, they report timings and check that both paths agree
+#define STDB_BENCHMARK_FLAGS (EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+#define STDB_TEST_FLAGS (EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * StdbBenchmark: Timing helpers shared by the plugin's and the game's automation benchmarks.
+ * Public so game modules can benchmark their own table layouts the same way.
+ */
+namespace StdbBenchmark
+{
+	/** Best of Runs timings of Body in seconds, the best run is the one least disturbed by the rest of the process */
+	inline double TimeBest(int32 Runs, TFunctionRef<void()> Body)
+	{
+		double Best = TNumericLimits<double>::Max();
+		for (int32 Run = 0; Run < Runs; ++Run)
+		{
+			const double Start = FPlatformTime::Seconds();
+			Body();
+			Best = FMath::Min(Best, FPlatformTime::Seconds() - Start);
+		}
+		return Best;
+	}
+
+	/** Logs two timings of the same work and how much faster the second one is */
+	inline void Report(FAutomationTestBase& Test, const TCHAR* What, const TCHAR* BaselineName, double Baseline,
+	                   const TCHAR* CandidateName, double Candidate)
+	{
+		Test.AddInfo(FString::Printf(TEXT("%s: %s %.3f ms, %s %.3f ms (%.2fx)"), What, BaselineName, Baseline * 1000.0,
+		                             CandidateName, Candidate * 1000.0, Candidate > 0.0 ? Baseline / Candidate : 0.0));
+	}
+
+	/** Same as Report, as throughput over Bytes of input */
+	inline void ReportThroughput(FAutomationTestBase& Test, const TCHAR* What, int64 Bytes, const TCHAR* BaselineName, double Baseline,
+	                             const TCHAR* CandidateName, double Candidate)
+	{
+		const double MegaBytes = static_cast<double>(Bytes) / (1024.0 * 1024.0);
+		Test.AddInfo(FString::Printf(TEXT("%s: %s %.1f MB/s, %s %.1f MB/s (%.2fx)"), What, BaselineName,
+		                             Baseline > 0.0 ? MegaBytes / Baseline : 0.0, CandidateName,
+		                             Candidate > 0.0 ? MegaBytes / Candidate : 0.0, Candidate > 0.0 ? Baseline / Candidate : 0.0));
+	}
+
+	/** Heap allocations Body makes on the calling thread, counted by standing in for GMalloc while it runs */
+	inline int64 CountAllocations(TFunctionRef<void()> Body)
+	{
+		struct FCountingMalloc final : FMalloc
+		{
+			FMalloc* Inner;
+			uint32 ThreadId;
+			int64 NumAllocations = 0;
+
+			explicit FCountingMalloc(FMalloc* InInner)
+				: Inner(InInner)
+				  , ThreadId(0)
+			{
+			}
+
+			void Count()
+			{
+				if (FPlatformTLS::GetCurrentThreadId() == ThreadId)
+				{
+					++NumAllocations;
+				}
+			}
+
+			virtual void* Malloc(SIZE_T Size, uint32 Alignment) override
+			{
+				Count();
+				return Inner->Malloc(Size, Alignment);
+			}
+
+			virtual void* Realloc(void* Original, SIZE_T Size, uint32 Alignment) override
+			{
+				// Shrinking to nothing is a free
+				if (Size > 0)
+				{
+					Count();
+				}
+				return Inner->Realloc(Original, Size, Alignment);
+			}
+
+			virtual void Free(void* Original) override { Inner->Free(Original); }
+			virtual SIZE_T QuantizeSize(SIZE_T Size, uint32 Alignment) override { return Inner->QuantizeSize(Size, Alignment); }
+			virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+			virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+			virtual const TCHAR* GetDescriptiveName() override { return TEXT("StdbBenchmarkCounter"); }
+		};
+
+		// Other threads keep allocating through the wrapper, only this thread's allocations are counted.
+		// It is never destroyed, a thread may still be inside it after GMalloc is put back
+		static FCountingMalloc Counter(GMalloc);
+		FMalloc* const Previous = GMalloc;
+		Counter.ThreadId = FPlatformTLS::GetCurrentThreadId();
+		Counter.NumAllocations = 0;
+		GMalloc = &Counter;
+		Body();
+		GMalloc = Previous;
+		return Counter.NumAllocations;
+	}
+}
+
+#endif
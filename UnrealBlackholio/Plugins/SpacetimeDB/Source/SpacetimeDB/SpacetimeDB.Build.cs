@@ -1,5 +1,6 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
+using System.IO;
 using UnrealBuildTool;
 
 public class SpacetimeDB : ModuleRules
@@ -40,6 +41,26 @@ public class SpacetimeDB : ModuleRules
 			);
 		
 		
+		AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
+
+		// Brotli is not shipped with the engine, drop headers and static libs into Source/ThirdParty/Brotli to enable it
+		string BrotliPath = Path.Combine(PluginDirectory, "Source", "ThirdParty", "Brotli");
+		string BrotliLibPath = Path.Combine(BrotliPath, "lib", Target.Platform.ToString());
+		bool bWithBrotli = Directory.Exists(BrotliLibPath);
+		if (bWithBrotli)
+		{
+			PrivateIncludePaths.Add(Path.Combine(BrotliPath, "include"));
+			foreach (string Lib in Directory.GetFiles(BrotliLibPath))
+			{
+				if (Lib.EndsWith(".lib") || Lib.EndsWith(".a"))
+				{
+					PublicAdditionalLibraries.Add(Lib);
+				}
+			}
+		}
+		PublicDefinitions.Add("WITH_STDB_BROTLI=" + (bWithBrotli ? "1" : "0"));
+		
+		
 		DynamicallyLoadedModuleNames.AddRange(
 			new string[]
 			{
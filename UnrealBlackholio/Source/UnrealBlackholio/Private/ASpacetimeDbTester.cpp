@@ -3,6 +3,7 @@
 
 #include "UnrealBlackholio/Public/ASpacetimeDbTester.h"
 
+#include "UnrealBlackholio/Public/BlackholioTables.h"
 #include "FStdbClientBuilder.h"
 #include "FStdbIdentity.h"
 #include "UnrealBlackholio/UnrealBlackholio.h"
@@ -26,6 +27,7 @@ void AASpacetimeDbTester::BeginPlay()
 		.WithModuleName(TEXT("unrealblackholio"))
 		.WithToken(TEXT(""))
 		.WithCompression(EStdbCompression::None)
+		.WithTables(&BlackholioTables::Register)
 		.OnConnect([this](FStdbIdentity Identity, FString Token) {
 			UE_LOG(LogUbo, Log, TEXT("Connected! Token: %s"), *Token);
 			Conn->LegacySubscribe();
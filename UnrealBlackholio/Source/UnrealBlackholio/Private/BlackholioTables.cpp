@@ -0,0 +1,66 @@
+#include "UnrealBlackholio/Public/BlackholioTables.h"
+
+#include "ClientCache/FStdbClientCache.h"
+#include "ClientCache/TStdbSparseSetStorage.h"
+#include "ClientApi/FBsatnColumnDecoder.h"
+
+namespace BlackholioTables
+{
+	void Register(FStdbClientCache& Cache)
+	{
+		Cache.RegisterTable<FDbConfig>(TEXT("config"));
+
+		// Entities and circles change every tick and every transaction would be patched into their
+		// snapshots, so they have none. Something off the game thread that reads them has to call
+		// EnableSnapshots before their rows arrive, before connecting or while the tables are empty
+		Cache.RegisterTable<FDbEntity, FDbEntityStorage>(TEXT("entity"));
+		Cache.RegisterTable<FDbCircle, FDbCircleStorage>(TEXT("circle"))
+			.AddBTreeIndex(TEXT("player_id"), &FDbCircle::PlayerId);
+
+		// Food is eaten and respawned under fresh auto_inc ids all the time
+		Cache.RegisterTable<FDbFood, TStdbSparseSetStorage<FDbFood>>(TEXT("food"));
+		Cache.RegisterTable<FDbPlayer>(TEXT("player"))
+			.AddUniqueIndex(TEXT("player_id"), &FDbPlayer::PlayerId);
+	}
+
+	bool DecodeEntityRows(const FBsatnRowList& Rows, TArray<FDbEntity>& OutRows)
+	{
+		// u32 entity_id, f32 x, f32 y, u32 mass
+		if (Rows.GetFixedRowSize() != 16)
+		{
+			return false;
+		}
+		const int32 NumRows = Rows.Num();
+		if (NumRows == 0)
+		{
+			return true;
+		}
+
+		FDbEntity* FirstRow = OutRows.GetData() + OutRows.AddUninitialized(NumRows);
+		const FBsatnColumn Columns[] = {
+			FBsatnColumnDecoder::FieldColumn(0, FirstRow, &FDbEntity::EntityId),
+			FBsatnColumnDecoder::FieldColumn(4, FirstRow, &FDbEntity::Position),
+			FBsatnColumnDecoder::FieldColumn(12, FirstRow, &FDbEntity::Mass)
+		};
+		verify(FBsatnColumnDecoder::DecodeFixedRows(Rows, Columns));
+		return true;
+	}
+
+	bool DecodeFoodRows(const FBsatnRowList& Rows, TArray<FDbFood>& OutRows)
+	{
+		if (Rows.GetFixedRowSize() != 4)
+		{
+			return false;
+		}
+		const int32 NumRows = Rows.Num();
+		if (NumRows == 0)
+		{
+			return true;
+		}
+
+		FDbFood* FirstRow = OutRows.GetData() + OutRows.AddUninitialized(NumRows);
+		const FBsatnColumn Column = FBsatnColumnDecoder::FieldColumn(0, FirstRow, &FDbFood::EntityId);
+		verify(FBsatnColumnDecoder::DecodeFixedRows(Rows, MakeArrayView(&Column, 1)));
+		return true;
+	}
+}
@@ -0,0 +1,169 @@
+﻿#include "Misc/AutomationTest.h"
+#include "UnrealBlackholio/Public/BlackholioTables.h"
+#include "ClientApi/FServerMessage.h"
+#include "Tests/StdbBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	FDbEntity MakeEntity(int32 i)
+	{
+		FDbEntity Entity;
+		Entity.EntityId = 1000 + i;
+		Entity.Position = {i * 0.5f, -i * 0.25f};
+		Entity.Mass = i % 97;
+		return Entity;
+	}
+
+	/** A row list as the server sends it, FixedSize if RowSize is set, delimited by offsets otherwise */
+	template<typename TRow>
+	TArray<uint8> WriteRowList(const TArray<TRow>& Rows, uint16 RowSize)
+	{
+		TArray<uint8> RowBytes;
+		FBinaryWriter RowWriter(RowBytes);
+		TArray<uint64> Offsets;
+		for (const TRow& Row : Rows)
+		{
+			Offsets.Add(RowWriter.GetPosition());
+			Row.WriteFields(RowWriter);
+		}
+
+		TArray<uint8> Message;
+		FBinaryWriter Writer(Message);
+		if (RowSize > 0)
+		{
+			Writer.WriteByte(0);
+			Writer.WriteUInt16(RowSize);
+		}
+		else
+		{
+			Writer.WriteByte(1);
+			Writer.WritePrimitiveArray(Offsets);
+		}
+		Writer.WritePrimitiveArray(RowBytes);
+		return Message;
+	}
+
+	/** Reads a row list back, its rows stay a view into Message */
+	FBsatnRowList ReadRowList(const TArray<uint8>& Message)
+	{
+		FBinaryReader Reader(Message);
+		FBsatnRowList Rows;
+		Rows.ReadFields(Reader);
+		return Rows;
+	}
+
+	bool SameEntities(const TArray<FDbEntity>& Decoded, const TArray<FDbEntity>& Rows)
+	{
+		bool bAllMatch = Decoded.Num() == Rows.Num();
+		for (int32 i = 0; bAllMatch && i < Rows.Num(); ++i)
+		{
+			bAllMatch = Decoded[i].EntityId == Rows[i].EntityId
+				&& Decoded[i].Position.X == Rows[i].Position.X && Decoded[i].Position.Y == Rows[i].Position.Y
+				&& Decoded[i].Mass == Rows[i].Mass;
+		}
+		return bAllMatch;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBlackholioEntityRowsTest, "SpacetimeDB.Codec.EntityRows", STDB_TEST_FLAGS)
+
+bool FBlackholioEntityRowsTest::RunTest(const FString& Parameters)
+{
+	// Not a multiple of four, the last rows take the same scalar path as the others
+	for (const int32 NumRows : {0, 1, 4, 7, 1027})
+	{
+		TArray<FDbEntity> Entities;
+		for (int32 i = 0; i < NumRows; ++i)
+		{
+			Entities.Add(MakeEntity(i));
+		}
+
+		const TArray<uint8> Fixed = WriteRowList(Entities, 16);
+		TArray<FDbEntity> FixedRows;
+		TestTrue(FString::Printf(TEXT("%d fixed-size entity rows take the column decoder"), NumRows),
+			BlackholioTables::DecodeEntityRows(ReadRowList(Fixed), FixedRows) && SameEntities(FixedRows, Entities));
+
+		// What the decode workers call for an entity diff
+		TArray<FDbEntity> DiffRows;
+		ReadRowList(Fixed).DecodeRows(DiffRows);
+		TestTrue(FString::Printf(TEXT("%d fixed-size entity rows decode through DecodeRows"), NumRows), SameEntities(DiffRows, Entities));
+
+		const TArray<uint8> Delimited = WriteRowList(Entities, 0);
+		TArray<FDbEntity> DelimitedRows;
+		TestFalse(FString::Printf(TEXT("%d entity rows with offsets are left to the row reader"), NumRows),
+			BlackholioTables::DecodeEntityRows(ReadRowList(Delimited), DelimitedRows));
+		ReadRowList(Delimited).DecodeRows(DelimitedRows);
+		TestTrue(FString::Printf(TEXT("%d entity rows with offsets decode row by row"), NumRows), SameEntities(DelimitedRows, Entities));
+	}
+
+	// Appends after the rows already decoded
+	TArray<FDbEntity> Entities = {MakeEntity(1), MakeEntity(2)};
+	TArray<FDbEntity> Decoded;
+	ReadRowList(WriteRowList(TArray<FDbEntity>{MakeEntity(0)}, 16)).DecodeRows(Decoded);
+	ReadRowList(WriteRowList(Entities, 16)).DecodeRows(Decoded);
+	Entities.Insert(MakeEntity(0), 0);
+	TestTrue(TEXT("Decoded rows are appended"), SameEntities(Decoded, Entities));
+
+	TArray<FDbFood> Food;
+	for (int32 i = 0; i < 9; ++i)
+	{
+		FDbFood Row;
+		Row.EntityId = 500 + i;
+		Food.Add(Row);
+	}
+	for (const uint16 RowSize : {4, 0})
+	{
+		TArray<FDbFood> Rows;
+		ReadRowList(WriteRowList(Food, RowSize)).DecodeRows(Rows);
+		bool bAllMatch = Rows.Num() == Food.Num();
+		for (int32 i = 0; bAllMatch && i < Food.Num(); ++i)
+		{
+			bAllMatch = Rows[i].EntityId == Food[i].EntityId;
+		}
+		TestTrue(FString::Printf(TEXT("Food rows decode with row size %d"), RowSize), bAllMatch);
+	}
+	TArray<FDbFood> FoodRows;
+	TestTrue(TEXT("Fixed-size food rows take the column decoder"), BlackholioTables::DecodeFoodRows(ReadRowList(WriteRowList(Food, 4)), FoodRows));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBlackholioEntityRowsBenchmark, "SpacetimeDB.Benchmark.EntityRows", STDB_BENCHMARK_FLAGS)
+
+bool FBlackholioEntityRowsBenchmark::RunTest(const FString& Parameters)
+{
+	const int32 NumRows = 1 << 20;
+	TArray<FDbEntity> Entities;
+	Entities.Reserve(NumRows);
+	for (int32 i = 0; i < NumRows; ++i)
+	{
+		Entities.Add(MakeEntity(i));
+	}
+	const TArray<uint8> Message = WriteRowList(Entities, 16);
+	const FBsatnRowList Rows = ReadRowList(Message);
+
+	// What an entity diff cost before the decoder: an FBinaryReader per row
+	TArray<FDbEntity> PerRow;
+	const double PerRowSeconds = StdbBenchmark::TimeBest(10, [&]
+	{
+		PerRow.Reset(NumRows);
+		for (int32 i = 0; i < NumRows; ++i)
+		{
+			PerRow.Add(Rows.GetRow(i).Decode<FDbEntity>());
+		}
+	});
+
+	TArray<FDbEntity> Decoded;
+	const double DecoderSeconds = StdbBenchmark::TimeBest(10, [&]
+	{
+		Decoded.Reset(NumRows);
+		Rows.DecodeRows(Decoded);
+	});
+
+	TestTrue(TEXT("Both paths decode the same rows"), SameEntities(Decoded, Entities) && SameEntities(PerRow, Entities));
+	StdbBenchmark::Report(*this, TEXT("Decode 1M entity rows"), TEXT("per row reader"), PerRowSeconds, TEXT("column decoder"), DecoderSeconds);
+	return true;
+}
+
+#endif
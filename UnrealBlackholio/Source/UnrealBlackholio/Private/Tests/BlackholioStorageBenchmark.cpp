@@ -0,0 +1,63 @@
+﻿#include "Misc/AutomationTest.h"
+#include "UnrealBlackholio/Public/BlackholioTables.h"
+#include "ClientCache/TStdbRowStorage.h"
+#include "Tests/StdbBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Lives with the game module since the column storages do, the plugin's own benchmarks are under its Private/Tests
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBlackholioEntityLayoutBenchmark, "SpacetimeDB.Benchmark.EntityLayout", STDB_BENCHMARK_FLAGS)
+
+bool FBlackholioEntityLayoutBenchmark::RunTest(const FString& Parameters)
+{
+	const int32 NumEntities = 100000;
+
+	TStdbRowStorage<FDbEntity> Rows;
+	FDbEntityStorage Columns;
+	Rows.Reserve(NumEntities);
+	Columns.Reserve(NumEntities);
+	for (int32 i = 0; i < NumEntities; ++i)
+	{
+		FDbEntity Entity;
+		Entity.EntityId = i + 1;
+		Entity.Position = {static_cast<float>(i % 1000), static_cast<float>(i / 1000)};
+		Entity.Mass = 1 + i % 50;
+		Rows.AddOrReplace(Entity);
+		Columns.AddOrReplace(Entity);
+	}
+
+	// The per frame sweep: mass weighted centre of every entity, touching positions and masses only
+	FVector2D RowCentre;
+	const double RowSeconds = StdbBenchmark::TimeBest(20, [&Rows, &RowCentre]
+	{
+		FVector2D Sum(0.0, 0.0);
+		double TotalMass = 0.0;
+		for (const FDbEntity& Entity : Rows.GetRows())
+		{
+			Sum += FVector2D(Entity.Position.X, Entity.Position.Y) * Entity.Mass;
+			TotalMass += Entity.Mass;
+		}
+		RowCentre = Sum / TotalMass;
+	});
+
+	FVector2D ColumnCentre;
+	const double ColumnSeconds = StdbBenchmark::TimeBest(20, [&Columns, &ColumnCentre]
+	{
+		const TArrayView<const FDbVector2> Positions = Columns.GetPositions();
+		const TArrayView<const uint32> Masses = Columns.GetMasses();
+		FVector2D Sum(0.0, 0.0);
+		double TotalMass = 0.0;
+		for (int32 i = 0; i < Positions.Num(); ++i)
+		{
+			Sum += FVector2D(Positions[i].X, Positions[i].Y) * Masses[i];
+			TotalMass += Masses[i];
+		}
+		ColumnCentre = Sum / TotalMass;
+	});
+
+	TestTrue(TEXT("Both layouts sweep the same rows"), RowCentre.Equals(ColumnCentre, 1e-6));
+	StdbBenchmark::Report(*this, TEXT("Sweep 100k entities"), TEXT("rows"), RowSeconds, TEXT("columns"), ColumnSeconds);
+	return true;
+}
+
+#endif
@@ -0,0 +1,345 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FBinaryReader.h"
+#include "FBinaryWriter.h"
+#include "FStdbIdentity.h"
+#include "FTimestamp.h"
+#include "TStdbBsatn.h"
+#include "ClientCache/FStdbSparseIndex.h"
+
+class FStdbClientCache;
+struct FBsatnRowList;
+
+/**
+ * Row types for the tables declared in server-rust/src/lib.rs, STDB_BSATN_FIELDS lists the fields in BSATN order.
+ */
+struct FDbVector2
+{
+	float X = 0.f;
+	float Y = 0.f;
+
+	STDB_BSATN_FIELDS(X, Y)
+};
+
+struct FDbConfig
+{
+	using FPrimaryKey = uint32;
+
+	uint32 Id = 0;
+	uint64 WorldSize = 0;
+
+	FPrimaryKey GetPrimaryKey() const { return Id; }
+
+	STDB_BSATN_FIELDS(Id, WorldSize)
+};
+
+struct FDbEntity
+{
+	using FPrimaryKey = uint32;
+
+	uint32 EntityId = 0;
+	FDbVector2 Position;
+	uint32 Mass = 0;
+
+	FPrimaryKey GetPrimaryKey() const { return EntityId; }
+
+	STDB_BSATN_FIELDS(EntityId, Position, Mass)
+};
+
+struct FDbCircle
+{
+	using FPrimaryKey = uint32;
+
+	uint32 EntityId = 0;
+	uint32 PlayerId = 0;
+	FDbVector2 Direction;
+	float Speed = 0.f;
+	FTimestamp LastSplitTime;
+
+	FPrimaryKey GetPrimaryKey() const { return EntityId; }
+
+	STDB_BSATN_FIELDS(EntityId, PlayerId, Direction, Speed, LastSplitTime)
+};
+
+struct FDbFood
+{
+	using FPrimaryKey = uint32;
+
+	uint32 EntityId = 0;
+
+	FPrimaryKey GetPrimaryKey() const { return EntityId; }
+
+	STDB_BSATN_FIELDS(EntityId)
+};
+
+struct FDbPlayer
+{
+	using FPrimaryKey = FStdbIdentity;
+
+	FStdbIdentity Identity;
+	uint32 PlayerId = 0;
+	FString Name;
+
+	FPrimaryKey GetPrimaryKey() const { return Identity; }
+
+	STDB_BSATN_FIELDS(Identity, PlayerId, Name)
+};
+
+/**
+ * FDbEntityStorage: Column layout for the entity table. Rendering and interpolation sweep
+ * positions and masses every frame, so each field lives in its own contiguous array and
+ * all arrays share the dense index stored per entity id. entity_id is #[auto_inc], so that
+ * index is a sparse array instead of a hash map.
+ */
+class FDbEntityStorage
+{
+public:
+	using FPrimaryKey = uint32;
+
+	int32 Num() const { return EntityIds.Num(); }
+
+	void Reserve(int32 Number)
+	{
+		EntityIds.Reserve(Number);
+		Positions.Reserve(Number);
+		Masses.Reserve(Number);
+	}
+
+	void Reset()
+	{
+		EntityIds.Reset();
+		Positions.Reset();
+		Masses.Reset();
+		IndexById.Reset();
+	}
+
+	int32 FindIndex(uint32 EntityId) const
+	{
+		return IndexById.Find(EntityId);
+	}
+
+	bool Contains(uint32 EntityId) const { return IndexById.Contains(EntityId); }
+
+	TArrayView<const uint32> GetEntityIds() const { return EntityIds; }
+	TArrayView<const FDbVector2> GetPositions() const { return Positions; }
+	TArrayView<const uint32> GetMasses() const { return Masses; }
+
+	bool FindRow(uint32 EntityId, FDbEntity& OutRow) const
+	{
+		const int32 Index = FindIndex(EntityId);
+		if (Index == INDEX_NONE)
+		{
+			return false;
+		}
+		OutRow = GetRow(Index);
+		return true;
+	}
+
+	FDbEntity GetRow(int32 Index) const
+	{
+		FDbEntity Row;
+		Row.EntityId = EntityIds[Index];
+		Row.Position = Positions[Index];
+		Row.Mass = Masses[Index];
+		return Row;
+	}
+
+	bool Remove(uint32 EntityId)
+	{
+		const int32 Index = IndexById.Remove(EntityId);
+		if (Index == INDEX_NONE)
+		{
+			return false;
+		}
+
+		const int32 LastIndex = EntityIds.Num() - 1;
+		if (Index != LastIndex)
+		{
+			EntityIds[Index] = EntityIds[LastIndex];
+			Positions[Index] = Positions[LastIndex];
+			Masses[Index] = Masses[LastIndex];
+			IndexById.Update(EntityIds[Index], Index);
+		}
+		EntityIds.Pop(/* bAllowShrinking = */ false);
+		Positions.Pop(/* bAllowShrinking = */ false);
+		Masses.Pop(/* bAllowShrinking = */ false);
+		return true;
+	}
+
+	bool AddOrReplace(const FDbEntity& Row)
+	{
+		int32 Index = FindIndex(Row.EntityId);
+		const bool bReplaced = Index != INDEX_NONE;
+		if (!bReplaced)
+		{
+			Index = EntityIds.Add(Row.EntityId);
+			Positions.AddUninitialized();
+			Masses.AddUninitialized();
+			IndexById.Add(Row.EntityId, Index);
+		}
+		Positions[Index] = Row.Position;
+		Masses[Index] = Row.Mass;
+		return bReplaced;
+	}
+
+private:
+	TArray<uint32> EntityIds;
+	TArray<FDbVector2> Positions;
+	TArray<uint32> Masses;
+	FStdbSparseIndex IndexById;
+};
+
+/**
+ * FDbCircleStorage: Column layout for the circle table, see FDbEntityStorage.
+ */
+class FDbCircleStorage
+{
+public:
+	using FPrimaryKey = uint32;
+
+	int32 Num() const { return EntityIds.Num(); }
+
+	void Reserve(int32 Number)
+	{
+		EntityIds.Reserve(Number);
+		PlayerIds.Reserve(Number);
+		Directions.Reserve(Number);
+		Speeds.Reserve(Number);
+		LastSplitTimes.Reserve(Number);
+	}
+
+	void Reset()
+	{
+		EntityIds.Reset();
+		PlayerIds.Reset();
+		Directions.Reset();
+		Speeds.Reset();
+		LastSplitTimes.Reset();
+		IndexById.Reset();
+	}
+
+	int32 FindIndex(uint32 EntityId) const
+	{
+		return IndexById.Find(EntityId);
+	}
+
+	bool Contains(uint32 EntityId) const { return IndexById.Contains(EntityId); }
+
+	TArrayView<const uint32> GetEntityIds() const { return EntityIds; }
+	TArrayView<const uint32> GetPlayerIds() const { return PlayerIds; }
+	TArrayView<const FDbVector2> GetDirections() const { return Directions; }
+	TArrayView<const float> GetSpeeds() const { return Speeds; }
+	TArrayView<const FTimestamp> GetLastSplitTimes() const { return LastSplitTimes; }
+
+	bool FindRow(uint32 EntityId, FDbCircle& OutRow) const
+	{
+		const int32 Index = FindIndex(EntityId);
+		if (Index == INDEX_NONE)
+		{
+			return false;
+		}
+		OutRow = GetRow(Index);
+		return true;
+	}
+
+	FDbCircle GetRow(int32 Index) const
+	{
+		FDbCircle Row;
+		Row.EntityId = EntityIds[Index];
+		Row.PlayerId = PlayerIds[Index];
+		Row.Direction = Directions[Index];
+		Row.Speed = Speeds[Index];
+		Row.LastSplitTime = LastSplitTimes[Index];
+		return Row;
+	}
+
+	bool Remove(uint32 EntityId)
+	{
+		const int32 Index = IndexById.Remove(EntityId);
+		if (Index == INDEX_NONE)
+		{
+			return false;
+		}
+
+		const int32 LastIndex = EntityIds.Num() - 1;
+		if (Index != LastIndex)
+		{
+			EntityIds[Index] = EntityIds[LastIndex];
+			PlayerIds[Index] = PlayerIds[LastIndex];
+			Directions[Index] = Directions[LastIndex];
+			Speeds[Index] = Speeds[LastIndex];
+			LastSplitTimes[Index] = LastSplitTimes[LastIndex];
+			IndexById.Update(EntityIds[Index], Index);
+		}
+		EntityIds.Pop(/* bAllowShrinking = */ false);
+		PlayerIds.Pop(/* bAllowShrinking = */ false);
+		Directions.Pop(/* bAllowShrinking = */ false);
+		Speeds.Pop(/* bAllowShrinking = */ false);
+		LastSplitTimes.Pop(/* bAllowShrinking = */ false);
+		return true;
+	}
+
+	bool AddOrReplace(const FDbCircle& Row)
+	{
+		int32 Index = FindIndex(Row.EntityId);
+		const bool bReplaced = Index != INDEX_NONE;
+		if (!bReplaced)
+		{
+			Index = EntityIds.Add(Row.EntityId);
+			PlayerIds.AddUninitialized();
+			Directions.AddUninitialized();
+			Speeds.AddUninitialized();
+			LastSplitTimes.AddDefaulted();
+			IndexById.Add(Row.EntityId, Index);
+		}
+		PlayerIds[Index] = Row.PlayerId;
+		Directions[Index] = Row.Direction;
+		Speeds[Index] = Row.Speed;
+		LastSplitTimes[Index] = Row.LastSplitTime;
+		return bReplaced;
+	}
+
+private:
+	TArray<uint32> EntityIds;
+	TArray<uint32> PlayerIds;
+	TArray<FDbVector2> Directions;
+	TArray<float> Speeds;
+	TArray<FTimestamp> LastSplitTimes;
+	FStdbSparseIndex IndexById;
+};
+
+namespace BlackholioTables
+{
+	/** Registers every Blackholio table with the connection's client cache */
+	UNREALBLACKHOLIO_API void Register(FStdbClientCache& Cache);
+
+	/** Appends the entity rows of Rows to OutRows if they are 16 byte rows, returns false without appending otherwise */
+	UNREALBLACKHOLIO_API bool DecodeEntityRows(const FBsatnRowList& Rows, TArray<FDbEntity>& OutRows);
+
+	/** Appends the food rows of Rows to OutRows if they are 4 byte rows, returns false without appending otherwise */
+	UNREALBLACKHOLIO_API bool DecodeFoodRows(const FBsatnRowList& Rows, TArray<FDbFood>& OutRows);
+}
+
+/** Entity and food diffs are decoded on the decode workers, their fixed-size rows go through the column decoder */
+template<>
+struct TStdbFixedRowDecoder<FDbEntity>
+{
+	static constexpr bool bEnabled = true;
+
+	static bool Decode(const FBsatnRowList& Rows, TArray<FDbEntity>& OutRows)
+	{
+		return BlackholioTables::DecodeEntityRows(Rows, OutRows);
+	}
+};
+
+template<>
+struct TStdbFixedRowDecoder<FDbFood>
+{
+	static constexpr bool bEnabled = true;
+
+	static bool Decode(const FBsatnRowList& Rows, TArray<FDbFood>& OutRows)
+	{
+		return BlackholioTables::DecodeFoodRows(Rows, OutRows);
+	}
+};